@@ -0,0 +1,138 @@
+/*
+ * example10.cpp -- Cells of an implicit curve and of an implicit surface
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to find the cells of the curve
+ *
+ *   (x^2 + y^2 - 1)^3 - x^2*y^3 = 0
+ *
+ * with a quadtree (it is drawn with characters, one per cell of the
+ * finest level) and the cells of the torus
+ *
+ *   (x^2 + y^2 + z^2 + R^2 - r^2)^2 - 4*R^2*(x^2 + y^2) = 0
+ *
+ * with an octree, on 1 and THREADS threads
+ *
+ * Usage: ./example10 DEPTH THREADS
+ *
+ * Compile : g++ -laffa example10.cpp -o example10
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+
+using namespace std;
+
+
+// The functions are templates, so they could also be evaluated on
+// doubles
+
+template <class T> T heart(const T * x, void *)
+{
+    const T r = x[0]*x[0] + x[1]*x[1] - 1.;
+    return r*r*r - x[0]*x[0]*x[1]*x[1]*x[1];
+}
+
+template <class T> T torus(const T * x, void *)
+{
+    const double R = 1, r = 0.4;
+    const T s = x[0]*x[0] + x[1]*x[1];
+    const T q = s + x[2]*x[2] + (R*R - r*r);
+    return q*q - s*(4*R*R);
+}
+
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+int main(int argc, char * argv[])
+{
+    unsigned depth = 6;
+    unsigned threads = 4;
+
+    if (argc > 1)
+        depth = atoi(argv[1]);
+    if (argc > 2)
+        threads = atoi(argv[2]);
+
+    // The curve, drawn with one character per cell of the finest level
+
+    const double lo2[2] = { -1.5, -1.5 };
+    const double hi2[2] = { 1.5, 1.5 };
+
+    aa_raster curve(2, heart<AAF>);
+    curve.set_domain(lo2, hi2);
+    curve.set_depth(depth);
+
+    vector<aa_cell> cells;
+    curve.run(cells);
+
+    const unsigned n = 1u << depth;
+    vector<string> rows(n, string(n, ' '));
+    for (unsigned k = 0; k < cells.size(); k++) {
+        const unsigned i = (unsigned)((cells[k].lo[0] - lo2[0])/(hi2[0] - lo2[0])*n);
+        const unsigned j = (unsigned)((cells[k].lo[1] - lo2[1])/(hi2[1] - lo2[1])*n);
+        rows[n - 1 - j][i] = '#';
+    }
+
+    if (depth <= 7)
+        for (unsigned j = 0; j < n; j++)
+            cout << rows[j] << endl;
+    cout << cells.size() << " cells of " << n*n << endl << endl;
+
+    // The torus, with 1 and then several threads
+
+    const double lo3[3] = { -1.5, -1.5, -0.5 };
+    const double hi3[3] = { 1.5, 1.5, 0.5 };
+
+    aa_raster surface(3, torus<AAF>);
+    surface.set_domain(lo3, hi3);
+    surface.set_depth(depth);
+    surface.set_flatness(0.05);
+
+    for (unsigned t = 1; t <= threads; t *= threads) {
+        surface.set_threads(t);
+        const double start = now();
+        surface.run(cells);
+        const double end = now();
+
+        unsigned flat = 0;
+        for (unsigned k = 0; k < cells.size(); k++)
+            if (cells[k].type == AA_CELL_FLAT)
+                flat++;
+
+        cout << "torus: " << cells.size() << " cells (" << flat << " flat) with "
+             << t << " thread(s) in " << end - start << "s" << endl;
+
+        if (threads == 1)
+            break;
+    }
+
+    return 0;
+}
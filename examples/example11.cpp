@@ -0,0 +1,172 @@
+/*
+ * example11.cpp -- Enclosures of a function and of its gradient
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to find the global minimum of the six-hump camel
+ * function
+ *
+ *   f(x,y) = (4 - 2.1*x^2 + x^4/3)*x^2 + x*y + (4*y^2 - 4)*y^2
+ *
+ * on [-2,2]x[-1,1] by branch and bound, down to boxes of width EPS
+ * f and its gradient are enclosed in one pass with aaf_dual<2> (forward
+ * mode) or with an aa_tape (reverse mode), a box is dropped when f is
+ * above the best value found so far or, with the gradient, when f is
+ * monotonic along x or y on it (and it doesn't touch the edge of the
+ * domain)
+ *
+ * Usage: ./example11 EPS
+ *
+ * Compile : g++ -laffa example11.cpp -o example11
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+
+template <class T> T camel(const T & x, const T & y)
+{
+    const T x2 = x*x;
+    const T y2 = y*y;
+    return (x2*(1./3) - 2.1)*x2*x2 + x2*4. + x*y + (y2*4. - 4.)*y2;
+}
+
+
+struct box
+{
+    interval x, y;
+};
+
+static const box domain = { interval(-2, 2), interval(-1, 1) };
+
+
+// f is monotonic along an axis on the box b, inside the domain
+
+static bool monotonic(const AAF & df, const interval & b, const interval & d)
+{
+    const interval g = df.convert();
+    return (g.left() > 0 && b.left() > d.left()) || (g.right() < 0 && b.right() < d.right());
+}
+
+
+// f and its gradient on the box b
+
+enum { NO_GRADIENT, FORWARD, REVERSE };
+
+static void evaluate(const box & b, int mode, AAF & f, AAF * df)
+{
+    if (mode == REVERSE) {
+        aa_tape tape;
+        aaf_var x = tape.input(AAF(b.x));
+        aaf_var y = tape.input(AAF(b.y));
+        const aaf_var v = camel(x, y);
+        f = v.value();
+        tape.gradient(v, df);
+    } else if (mode == FORWARD) {
+        aaf_dual<2> x(AAF(b.x), 0), y(AAF(b.y), 1);
+        const aaf_dual<2> v = camel(x, y);
+        f = v.value();
+        df[0] = v.deriv(0);
+        df[1] = v.deriv(1);
+    } else {
+        f = camel(AAF(b.x), AAF(b.y));
+    }
+}
+
+
+// Minimize f, the value is put in [lo,up] and the boxes evaluated in
+// evals
+
+static void minimize(double eps, int mode, double & lo, double & up, unsigned & evals)
+{
+    vector<box> todo(1, domain);
+    up = HUGE_VAL;
+    lo = HUGE_VAL;
+    evals = 0;
+
+    while (!todo.empty()) {
+        const box b = todo.back();
+        todo.pop_back();
+        evals++;
+
+        AAF f, df[2];
+        evaluate(b, mode, f, df);
+        const interval range = f.convert();
+
+        // f at the center of the box is an upper bound of the minimum
+
+        const double c = camel(AAF(b.x.mid()), AAF(b.y.mid())).convert().right();
+        if (c < up)
+            up = c;
+
+        if (range.left() > up)
+            continue;
+        if (mode != NO_GRADIENT && (monotonic(df[0], b.x, domain.x) ||
+                                    monotonic(df[1], b.y, domain.y)))
+            continue;
+
+        if (b.x.width() < eps) {
+            if (range.left() < lo)
+                lo = range.left();
+            continue;
+        }
+
+        // split along the longest side
+
+        box l = b, r = b;
+        if (b.x.width() >= b.y.width()) {
+            l.x = interval(b.x.left(), b.x.mid());
+            r.x = interval(b.x.mid(), b.x.right());
+        } else {
+            l.y = interval(b.y.left(), b.y.mid());
+            r.y = interval(b.y.mid(), b.y.right());
+        }
+        todo.push_back(l);
+        todo.push_back(r);
+    }
+
+    if (lo > up)
+        lo = up;
+}
+
+
+int main(int argc, char * argv[])
+{
+    double eps = 1e-4;
+
+    if (argc > 1)
+        eps = atof(argv[1]);
+
+    const char * name[] = { "without the gradient", "forward mode", "reverse mode" };
+
+    for (int mode = NO_GRADIENT; mode <= REVERSE; mode++) {
+        double lo, up;
+        unsigned evals;
+        minimize(eps, mode, lo, up, evals);
+
+        cout << name[mode] << ": min f in ["
+             << lo << "," << up << "], " << evals << " boxes" << endl;
+    }
+
+    return 0;
+}
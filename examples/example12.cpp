@@ -0,0 +1,127 @@
+/*
+ * example12.cpp -- Subdivision with affine and quadratic forms
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to find the range of
+ *
+ *   f(x,y) = (x^2 + y^2 - 1)^3 - x^2*y^3
+ *
+ * on [-1.5,1.5]^2 : the boxes where f may be 0 are split down to
+ * 2^DEPTH x 2^DEPTH cells, once with AAF and once with aaf_quad
+ * (keeping up to TERMS quadratic terms) whose tighter enclosures
+ * drop more boxes
+ *
+ * Usage: ./example12 DEPTH TERMS
+ *
+ * Compile : g++ -laffa example12.cpp -o example12
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <cstdlib>
+#include <iostream>
+#include <sys/time.h>
+#include <vector>
+
+using namespace std;
+
+
+template <class T> T heart(const T & x, const T & y)
+{
+    const T r = x*x + y*y - 1.;
+    return r*r*r - x*x*y*y*y;
+}
+
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+struct box
+{
+    interval x, y;
+};
+
+
+// Split the domain down to boxes of width 3/2^depth, the boxes where
+// f doesn't straddle 0 are dropped (see aa_raster), returns the number
+// of boxes evaluated and the ones left at the finest level in cells
+
+template <class T> unsigned subdivide(unsigned depth, unsigned & cells)
+{
+    box domain = { interval(-1.5, 1.5), interval(-1.5, 1.5) };
+    vector<pair<box, unsigned> > todo(1, make_pair(domain, 0u));
+    unsigned boxes = 0;
+    cells = 0;
+
+    while (!todo.empty()) {
+        const box b = todo.back().first;
+        const unsigned d = todo.back().second;
+        todo.pop_back();
+        boxes++;
+
+        const interval f = T(heart(T(AAF(b.x)), T(AAF(b.y)))).convert();
+        if (f.left() > 0 || f.right() < 0)
+            continue;
+        if (d == 2*depth) {
+            cells++;
+            continue;
+        }
+
+        box l = b, r = b;
+        if (d % 2 == 0) {
+            l.x = interval(b.x.left(), b.x.mid());
+            r.x = interval(b.x.mid(), b.x.right());
+        } else {
+            l.y = interval(b.y.left(), b.y.mid());
+            r.y = interval(b.y.mid(), b.y.right());
+        }
+        todo.push_back(make_pair(l, d + 1));
+        todo.push_back(make_pair(r, d + 1));
+    }
+
+    return boxes;
+}
+
+
+int main(int argc, char * argv[])
+{
+    unsigned depth = 10;
+
+    if (argc > 1)
+        depth = atoi(argv[1]);
+    if (argc > 2)
+        aaf_quad::set_max_terms(atoi(argv[2]));
+
+    unsigned cells;
+    double start = now();
+    unsigned n = subdivide<AAF>(depth, cells);
+    cout << "AAF: " << cells << " cells, " << n << " boxes in " << now() - start << "s" << endl;
+
+    start = now();
+    n = subdivide<aaf_quad>(depth, cells);
+    cout << "aaf_quad: " << cells << " cells, " << n << " boxes in " << now() - start << "s"
+         << endl;
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * example13.cpp -- Parallel evaluation of a recorded polynomial system
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to evaluate a system of EQS random polynomials
+ * in VARS unknowns (TERMS terms of degree up to 4 each) on boxes of
+ * [-1,1]^VARS : the system is recorded once on an aa_program, and
+ * evaluated on 1 and THREADS threads, which find the same AAFs
+ *
+ * Usage: ./example13 TERMS THREADS
+ *
+ * Compile : g++ -laffa example13.cpp -o example13
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <cstdlib>
+#include <iostream>
+#include <sys/time.h>
+#include <vector>
+
+using namespace std;
+
+#define VARS 6
+#define EQS 4
+#define BOXES 20
+
+
+// The equations, the terms of each one are added by aaf_sum()
+
+static void record(aa_program & p, unsigned terms)
+{
+    aaf_expr x[VARS];
+    for (unsigned i = 0; i < VARS; i++)
+        x[i] = p.input();
+
+    srand(1);
+    vector<aaf_expr> t(terms);
+    for (unsigned e = 0; e < EQS; e++) {
+        for (unsigned k = 0; k < terms; k++) {
+            aaf_expr m = (rand()%201 - 100)/100.;
+            for (unsigned d = rand()%5; d > 0; d--)
+                m = m*x[rand()%VARS];
+            t[k] = m;
+        }
+        p.output(aaf_sum(&t[0], terms));
+    }
+}
+
+
+// The AAFs of a and b have the same terms
+
+static bool same_forms(const vector<AAF> & a, const vector<AAF> & b)
+{
+    for (unsigned j = 0; j < a.size(); j++) {
+        if (a[j].get_center() != b[j].get_center() || a[j].get_length() != b[j].get_length())
+            return false;
+        for (unsigned i = 0; i < a[j].get_length(); i++)
+            if (a[j].get_index(i) != b[j].get_index(i) || a[j].get_coeff(i) != b[j].get_coeff(i))
+                return false;
+    }
+    return true;
+}
+
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+int main(int argc, char * argv[])
+{
+    unsigned terms = 2000;
+    unsigned threads = 4;
+
+    if (argc > 1)
+        terms = atoi(argv[1]);
+    if (argc > 2)
+        threads = atoi(argv[2]);
+
+    aa_program p;
+    record(p, terms);
+    cout << p.size() << " operations recorded" << endl;
+
+    // The boxes of side 0.1 along the diagonal
+
+    vector<AAF> x(VARS);
+    vector<AAF> y(EQS), first(EQS);
+    vector<interval> range(BOXES);
+    bool same = true;
+
+    // (the boxes get the same noise symbols each time)
+
+    const aa_symbol start_symbol = AAF::inclast();
+
+    for (unsigned t = 1; t <= threads; t *= threads) {
+        p.set_threads(t);
+        const double start = now();
+
+        for (unsigned b = 0; b < BOXES; b++) {
+            AAF::set_default(start_symbol);
+            const double c = -0.95 + 1.9*b/(BOXES - 1);
+            for (unsigned i = 0; i < VARS; i++)
+                x[i] = AAF(interval(c - 0.05, c + 0.05));
+
+            p.evaluate(&x[0], &y[0]);
+            range[b] = y[0].convert();
+            if (b == 0 && t == 1)
+                first = y;
+            else if (b == 0)
+                same = same_forms(first, y);
+        }
+
+        const double end = now();
+        cout << "f0 on the first box " << range[0] << ", on the last one "
+             << range[BOXES - 1] << endl;
+        cout << BOXES << " boxes with " << t << " thread(s) in " << end - start << "s" << endl;
+
+        if (threads == 1)
+            break;
+    }
+
+    if (threads > 1)
+        cout << (same ? "same AAFs" : "different AAFs") << " on 1 and " << threads
+             << " threads" << endl;
+
+    return 0;
+}
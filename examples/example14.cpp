@@ -0,0 +1,81 @@
+/*
+ * example14.cpp -- Shared subexpressions of a recorded program
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to evaluate the function of example6
+ *
+ *   333.75*b^6 + a^2*(11*a^2*b^2 - b^6 - 121*b^4 - 2) + 5.5*b^8 + a/(2*b)
+ *
+ * on a few boxes : in AA, recorded on an aa_program without the
+ * rewrites (b^6 and a*a are evaluated once) and with them (a*a is
+ * sqr(a), b^8 is the square of b^4, ...), whose results have fewer
+ * noise symbols
+ *
+ * Compile : g++ -laffa example14.cpp -o example14
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <iostream>
+
+using namespace std;
+
+
+template <class T> T f(const T & a, const T & b)
+{
+    return 333.75*pow(b, 6) + a*a*(11*a*a*b*b - pow(b, 6) - 121*pow(b, 4) - 2.)
+        + 5.5*pow(b, 8) + a/(2*b);
+}
+
+
+int main()
+{
+    aa_program plain, rewritten;
+    plain.set_rewrite(false);
+
+    aaf_expr a = plain.input();
+    aaf_expr b = plain.input();
+    plain.output(f(a, b));
+
+    a = rewritten.input();
+    b = rewritten.input();
+    rewritten.output(f(a, b));
+
+    for (unsigned k = 0; k < 3; k++) {
+        const double lo = 0.5 + 0.5*k;
+        AAF x[2] = { AAF(interval(lo, lo + 0.1)), AAF(interval(lo + 0.2, lo + 0.3)) };
+        AAF y[1];
+
+        cout << "a = " << x[0].convert() << ", b = " << x[1].convert() << endl;
+
+        const AAF r = f(x[0], x[1]);
+        cout << "  AA:            " << r.convert() << ", " << r.get_length()
+             << " noise symbols" << endl;
+
+        plain.evaluate(x, y);
+        cout << "  recorded:      " << y[0].convert() << ", " << y[0].get_length()
+             << " noise symbols" << endl;
+
+        rewritten.evaluate(x, y);
+        cout << "  with rewrites: " << y[0].convert() << ", " << y[0].get_length()
+             << " noise symbols" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * example15.cpp -- Round-off bounds of float affine forms
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to check the radius of aaf_float forms of
+ * 2^LOGN equal coefficients (0.7f and 0.9f), whose float sums lose
+ * much more than one rounding : the radius of the form, of its
+ * product by 0.9f and of its sum with itself must be at least the
+ * exact one (computed in double, where these sums are exact)
+ *
+ * Usage: ./example15 LOGN
+ *
+ * Compile : g++ -laffa example15.cpp -o example15
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+
+static bool check(const char * name, double r, interval range, double exact)
+{
+    const bool ok = r >= exact && range.right() >= exact && range.left() <= -exact;
+    cout.precision(17);
+    cout << name << ": radius " << r << ", exact " << exact
+         << (ok ? " ok" : " FAILED") << endl;
+    return ok;
+}
+
+
+int main(int argc, char * argv[])
+{
+    unsigned logn = 20;
+    if (argc > 1)
+        logn = atoi(argv[1]);
+    const unsigned n = 1u << logn;
+
+    bool ok = true;
+    const float coeff[2] = { 0.7f, 0.9f };
+
+    for (unsigned j = 0; j < 2; j++) {
+        vector<double> c(n, coeff[j]);
+        vector<aa_symbol> id(n);
+        for (unsigned i = 0; i < n; i++)
+            id[i] = i + 1;
+
+        const aaf_float f(AAF(0, &c[0], &id[0], n));
+
+        // (the products of two floats are exact in double)
+
+        const double exact = double(n)*coeff[j];
+        const double exact_prod = double(n)*(double(coeff[j])*double(0.9f));
+
+        cout << n << " coefficients of " << coeff[j] << endl;
+        const aaf_float g = f*0.9f;
+        const aaf_float h = f + f;
+        ok = check("  f", f.rad(), f.convert(), exact) && ok;
+        ok = check("  0.9f*f", g.rad(), g.convert(), exact_prod) && ok;
+        ok = check("  f + f", h.rad(), h.convert(), 2*exact) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
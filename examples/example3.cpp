@@ -23,7 +23,7 @@
 /* This is a program to compare precison between
  * the AA model and the IA model
  *
- * We use libEasyval by Johan Vervloet and Stefan Becuwe for the IA model
+ * We use the interval class of libaffa for the IA model
  *
  * You'll need gnuplot to display the datas
  *
@@ -49,8 +49,8 @@
  * Otherwise a missing box indicates a very small height
  * of the box.
  *
- * Compile : g++ -laffa -lEasyval example3.cpp -o example3
- * (requires libaffa and libEasyval)
+ * Compile : g++ -laffa example3.cpp -o example3
+ * (requires libaffa)
  *
  * (C) 2003 Olivier Gay <olivier.gay@a3.epfl.ch>
 */
@@ -61,7 +61,6 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <Easyval.hh>
 
 using namespace std;
 
@@ -105,7 +104,7 @@ int main(int argc, char **argv)
   interval itv;
   AAF u, v;  // v = v(u)
 
-  Easyval m,n;  // n = n(m)
+  interval m,n;  // n = n(m)
 
 
   if (argc < 4) 
@@ -183,7 +182,7 @@ int main(int argc, char **argv)
       x2=x1+width;
       xc=(x1+x2)/2;
 
-      itv.modlohi(x1,x2);
+      itv.mod_lo_hi(x1,x2);
       u=itv;
       v=eval_fct(u);
 
@@ -243,11 +242,11 @@ int main(int argc, char **argv)
       x2=x1+width;
       xc=(x1+x2)/2;
 
-      m.set(x1,x2);
+      m = interval(x1,x2);
       n=eval_fct(m);
 
-      y = n.midpoint();
-      ydelta = n.getSup()-y;
+      y = n.mid();
+      ydelta = n.right()-y;
       ydelta_tot2 += ydelta;
 
       data3 << "\t" << xc << "\t";
@@ -22,7 +22,7 @@
 /* This is a program to compare precison between
  * the AA model and the IA model
  *
- * We use libEasyval by Johan Vervloet and Stefan Becuwe for the IA model
+ * We use the interval class of libaffa for the IA model
  *
  * This example is written for a function y=f(x1,x2) but it can be easyly
  * changed to be used with a higher number of variables
@@ -35,8 +35,8 @@
  * If you want to change the function to display, you can change it in the
  * template fct eval_fct()
  *
- * Compile : g++ -laffa -lEasyval example4.cpp -o example4
- * (requires libaffa and libEasyval)
+ * Compile : g++ -laffa example4.cpp -o example4
+ * (requires libaffa)
  *
  * (C) 2003 Olivier Gay <olivier.gay@a3.epfl.ch>
  */
@@ -47,7 +47,6 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <Easyval.hh>
 
 using namespace std;
 
@@ -96,7 +95,7 @@ int main(int argc, char **argv)
   interval itv1, itv2;
   AAF u1, u2, v;  // v = v(u1,u2)
 
-  Easyval m1,m2, n;  // n = n(m1,m2)
+  interval m1,m2, n;  // n = n(m1,m2)
 
 
   if (argc != 6)
@@ -143,13 +142,13 @@ int main(int argc, char **argv)
       // x1
       x1_a=lbound1+i*width1;
       x1_b=x1_a+width1;
-      itv1.modlohi(x1_a,x1_b);
+      itv1.mod_lo_hi(x1_a,x1_b);
       u1=itv1;
 
       // x2
       x2_a=lbound2+i*width2;
       x2_b=x2_a+width2;
-      itv2.modlohi(x2_a,x2_b);
+      itv2.mod_lo_hi(x2_a,x2_b);
       u2=itv2;
 
 
@@ -192,17 +191,17 @@ int main(int argc, char **argv)
       // x1
       x1_a=lbound1+i*width1;
       x1_b=x1_a+width1;
-      m1.set(x1_a,x1_b);
+      m1 = interval(x1_a,x1_b);
 
       // x2
       x2_a=lbound2+i*width2;
       x2_b=x2_a+width2;
-      m2.set(x2_a,x2_b);
+      m2 = interval(x2_a,x2_b);
 
       n=eval_fct(m1,m2);
 
-      y = n.midpoint();
-      ydelta = n.getSup()-y;
+      y = n.mid();
+      ydelta = n.right()-y;
       ydelta_tot2 += ydelta;
 
       // We check if we calculated a non-finite value
@@ -1,4 +1,5 @@
 #include <aa_aaf.h>
+#include <aa_linear.h>
 
 /* By using affine arithmetic we should be able to make an estimate of
  * the variance of a function over an input range. */
@@ -77,6 +78,21 @@ int main() {
     std::cout << "new x = " << proj << proj.convert()
               << std::endl;
 
+    std::cout << "Trial 3, with aaf_contract\n";
+
+    // the same with the linearization of the library :
+    // the box of (x,y) is contracted to x*y - 1 = 0
+
+    interval box[2] = { interval(1.2, 1.5), interval(0.5, 1.) };
+
+    for (unsigned i = 0; i < 3; i++) {
+        AAF in[2] = { AAF(box[0]), AAF(box[1]) };
+        if (!aaf_contract(in[0]*in[1] - 1, in, box, 2, 0, 0))
+            break;
+        std::cout << "box = " << box[0] << " x " << box[1]
+                  << std::endl;
+    }
+
     return 0;
 }
 
@@ -0,0 +1,101 @@
+/*
+ * example8.cpp -- Time cost of the rigorous affine operations
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to compare the time of the affine operations
+ * with and without the round-off errors
+ *
+ * The same evaluations are done in the default mode of the lib and
+ * in an aa_rounding_scope (upward rounding)
+ * If libaffa was built with ./configure CPPFLAGS=-DAA_RIGOROUS the
+ * default mode bounds the round-off with error free transformations
+ * so building it both ways gives the three timings
+ *
+ * Usage: ./example8 BOXN
+ *
+ * Compile : g++ -laffa example8.cpp -o example8
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+using namespace std;
+
+// A mostly affine function of 4 variables
+
+AAF eval_fct(const AAF & x1, const AAF & x2, const AAF & x3, const AAF & x4)
+{
+  AAF y = 1 + 3*x1 - x2*2.5 + (x3 - x4)*0.1;
+  y = y + x1*x2 - (x3 + x4)*x1 + 0.5*y;
+  return y*y + x4;
+}
+
+// Time of BOXN evaluations, the total width goes in w
+
+double run(unsigned boxn, double & w)
+{
+  clock_t tstart = clock();
+
+  w = 0;
+
+  for (unsigned i=0; i < boxn; i++)
+    {
+      double a = (double)i/boxn;
+
+      AAF x1(interval(a, a+0.01));
+      AAF x2(interval(1-a, 1.02-a));
+      AAF x3(interval(-a, 0.1-a));
+      AAF x4(interval(a*a, a*a+0.05));
+
+      w += eval_fct(x1, x2, x3, x4).convert().width();
+    }
+
+  return (double)(clock()-tstart)/CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 2)
+    {
+      cout << "Usage: " << argv[0] << " BOXN" << endl;
+      return 0;
+    }
+
+  unsigned boxn = atoi(argv[1]);
+
+  double w1, w2;
+
+  double total1 = run(boxn, w1);
+  double total2;
+
+  {
+    aa_rounding_scope up;
+    total2 = run(boxn, w2);
+  }
+
+  cout << "Time of the affine operations with and without round-off" << endl;
+  cout << "default: " << total1 << "s (mean width " << w1/boxn << ")" << endl;
+  cout << "aa_rounding_scope: " << total2 << "s (mean width " << w2/boxn << ")"
+       << endl;
+
+  exit(0);
+}
@@ -0,0 +1,104 @@
+/*
+ * example9.cpp -- Integration of an ODE from an uncertain initial state
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* This is a program to enclose the solutions of the Lotka-Volterra
+ * equations
+ *
+ *   x' = x*(a - b*y)
+ *   y' = y*(d*x - c)
+ *
+ * from an initial state known within +-EPS, with the aa_ode integrator
+ * The state is condensed to KEEP noise symbols after each step so the
+ * length of the forms stays the same over the whole integration
+ *
+ * Usage: ./example9 TMAX EPS KEEP
+ *
+ * Compile : g++ -laffa example9.cpp -o example9
+ * (requires libaffa)
+*/
+
+#include <aa.h>
+#include <cstdlib>
+#include <iostream>
+
+
+// Right-hand side of the equations
+
+static void lotka_volterra(const AAF &, const AAF * y, AAF * dy, void *) {
+    dy[0] = y[0]*(AAF(1.5) - y[1]);
+    dy[1] = y[1]*(y[0] - AAF(3.));
+}
+
+
+// Print the enclosures every tenth of the time
+
+struct progress
+{
+    double next;
+    unsigned steps;
+};
+
+static void print_step(double t, double h, const interval *, const AAF * y, unsigned,
+                       void * data)
+{
+    progress * p = (progress *)data;
+    p->steps++;
+
+    if (t + h >= p->next) {
+        std::cout << "t = " << t + h << " (" << p->steps << " steps)\n";
+        std::cout << "  x in " << y[0].convert() << " [" << y[0].get_length() << "]\n";
+        std::cout << "  y in " << y[1].convert() << " [" << y[1].get_length() << "]\n";
+        p->next += 0.1*p->next + 0.5;
+    }
+}
+
+
+int main(int argc, char * argv[])
+{
+    double tmax = 10;
+    double eps = 0.01;
+    unsigned keep = 16;
+
+    if (argc > 1)
+        tmax = atof(argv[1]);
+    if (argc > 2)
+        eps = atof(argv[2]);
+    if (argc > 3)
+        keep = atoi(argv[3]);
+
+    AAF y[2] = { AAF(interval(3 - eps, 3 + eps)), AAF(interval(1 - eps, 1 + eps)) };
+
+    aa_ode ode(2, lotka_volterra);
+    ode.set_step(1e-3, 1e-8, 1e-2);
+    ode.set_tolerance(1e-3);
+    ode.set_condense(keep);
+
+    progress p = { 0.5, 0 };
+    double t = 0;
+
+    if (!ode.integrate(t, tmax, y, print_step, &p))
+        std::cout << "the integration stopped at t = " << t << "\n";
+
+    std::cout << "t = " << t << " (" << p.steps << " steps)\n";
+    std::cout << "  x = " << y[0] << "\n";
+    std::cout << "  y = " << y[1] << "\n";
+
+    return 0;
+}
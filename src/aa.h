@@ -27,6 +27,19 @@
 
 #include "aa_aaf.h"
 #include "aa_interval.h"
+#include "aa_hybrid.h"
+#include "aa_rounding.h"
+#include "aa_binary.h"
+#include "aa_stats.h"
+#include "aa_provenance.h"
+#include "aa_ode.h"
+#include "aa_raster.h"
+#include "aa_linear.h"
+#include "aa_dual.h"
+#include "aa_tape.h"
+#include "aa_quad.h"
+#include "aa_form.h"
+#include "aa_program.h"
 
 
 #endif  // AA_H
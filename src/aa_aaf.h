@@ -25,9 +25,11 @@
 #ifndef AA_AAF_H
 #define AA_AAF_H
 
+#include "aa_config.h"
 #include "aa_interval.h"
 #include <cmath>
 #include <iostream>
+#include <stdint.h>
 
 
 typedef enum AAF_TYPE{
@@ -37,6 +39,24 @@ typedef enum AAF_TYPE{
     AAF_TYPE_NAN=4
 } AAF_TYPE;
 
+class aa_roundoff;  // see aa_util.h
+
+
+// Noise symbol
+// Build with ./configure --enable-symbol64 to have 64 bit symbols, for
+// the applications which make more than 2^32 of them and can't
+// renumber them with aaf_compact() (the choice is recorded in the
+// installed aa_config.h)
+
+#if AA_SYMBOL_BITS == 64
+typedef uint64_t aa_symbol;
+#else
+typedef unsigned aa_symbol;
+#endif
+
+#define AA_SYMBOL_MAX ((aa_symbol)-1)
+
+
 // Affine Arithmetic Form
 
 class AAF
@@ -44,7 +64,11 @@ class AAF
 
 private:
     AAF_TYPE special; // infinite, nan
-    static unsigned last;  // highest noise symbol in use
+    static aa_symbol last;  // highest noise symbol in use
+    static __thread aa_symbol block_next;  // symbols of this thread (see use_block)
+    static __thread aa_symbol block_end;
+    static __thread bool block_out;
+    static bool fast;      // table driven non-affine operations
 
     double cvalue;       // central value vo
     unsigned length;         // lenght of indexes
@@ -52,13 +76,35 @@ private:
     // At creation we don't store null coefficients
 
     double * coefficients; // values of noise sym
-    unsigned * indexes;   // indexes of noise sym
+    aa_symbol * indexes;  // indexes of noise sym
+
+    // Total deviation, computed on demand by rad()
+    // and negative as long as it isn't known
+
+    mutable double radius_cache;
+
+    // false if the arrays belong to someone else (see AAFView)
+
+    bool owned;
+
+    // k-way merge of n scaled AAFs, with an optional error symbol
+    static AAF merge(unsigned n, const AAF * const * f, const double * scale,
+                     double v0, AAF_TYPE type, bool error, double delta);
+    static unsigned merge_heap(unsigned n, const AAF * const * f, const double * scale,
+                               aa_symbol * indexes, double * coefficients, bool & ovf,
+                               aa_roundoff & ro);
+
+    void add_error(double err);
+    AAF shift(double sign, double cst) const;
+    static void reserve(aa_symbol s);
+    void alias(double v0, const double * t1, const aa_symbol * t2, unsigned T,
+               AAF_TYPE t);
 
 public:
 
     AAF(AAF_TYPE t);
     AAF(double v0 = 0);
-    AAF(double v0, const double * t1, const unsigned * t2, unsigned T);
+    AAF(double v0, const double * t1, const aa_symbol * t2, unsigned T);
     AAF(const AAF & P);
 
     // affine constructor
@@ -81,15 +127,33 @@ public:
     friend AAF sin(const AAF & P);
     friend AAF pow(const AAF & P, double exp);
     friend AAF half_plane(const AAF & P);
+    friend AAF aaf_sum(const AAF * P, unsigned n);
+    friend AAF aaf_dot(const AAF * P, const AAF * Q, unsigned n);
+    friend aa_symbol aaf_compact(AAF * const * P, unsigned n);
+
+    // The operations with a constant don't make an AAF of it :
+    // + and - only change the center
 
     AAF operator - () const;
+    AAF operator + (double) const;
+    AAF operator - (double) const;
     AAF operator * (double) const;
+    AAF operator / (double) const;
+    friend AAF operator - (double, const AAF & P);
 
     friend std::ostream & operator << (std::ostream & s, const AAF &P);
+    friend class aaf_packed;
+    friend class AAFView;
+    friend class aaf_quad;
 
     void aafprint() const;
-    static void set_default(const unsigned val=0);
-    static unsigned inclast();
+    static void set_default(const aa_symbol val=0);
+    static aa_symbol inclast();
+    static aa_symbol reserve_block(aa_symbol n);
+    static void use_block(aa_symbol first, aa_symbol n);
+    static bool block_overflow();
+    static void set_fast_mode(bool on=true);
+    static bool fast_mode();
     unsigned get_length() const;
     double get_center() const;
     interval convert() const;
@@ -99,12 +163,12 @@ public:
             return 0;
         return coefficients[i];
     }
-    unsigned get_index(unsigned i) const {
+    aa_symbol get_index(unsigned i) const {
         if(i >= length)
             return 0;
         return indexes[i];
     }
-    double index_coeff(unsigned index) const;
+    double index_coeff(aa_symbol index) const;
     bool is_indeterminate() const;
     bool is_infinite() const;
     bool is_nan() const;
@@ -115,15 +179,19 @@ public:
     }
 };
 
-AAF operator * (const double, const AAF);
-AAF operator + (const double, const AAF);
-AAF operator - (const double, const AAF);
+AAF operator * (double, const AAF & P);
+AAF operator + (double, const AAF & P);
+AAF operator - (double, const AAF & P);
+AAF operator / (double, const AAF & P);
 AAF abs(const AAF & P);
 AAF sqr(const AAF & P);
+AAF sqrt(const AAF & P);
+AAF inv(const AAF & P);
 AAF exp(const AAF & P);
 AAF log(const AAF & P);
 AAF pow(const AAF & P, int exp);
 AAF pow(const AAF & P, double exp);
+AAF sin(const AAF & P);
 AAF cos(const AAF & P);
 AAF tan(const AAF & P);
 AAF cotan(const AAF);
@@ -137,35 +205,67 @@ AAF atanh(const AAF & P);
 
 AAF half_plane(const AAF & P);
 
+AAF aaf_sum(const AAF * P, unsigned n);
+AAF aaf_dot(const AAF * P, const AAF * Q, unsigned n);
+
+aa_symbol aaf_compact(AAF * const * P, unsigned n);
+
 // AAF inline functions
 
 // Create a constant AAF of v0
 
 inline AAF:: AAF(double v0):
     special(AAF_TYPE_AFFINE), cvalue(v0), length(0),
-    coefficients(NULL), indexes(NULL)
+    coefficients(NULL), indexes(NULL), radius_cache(0), owned(true)
 {
 }
 
 inline AAF:: AAF(AAF_TYPE t):
     special(t), cvalue(0), length(0),
-    coefficients(NULL), indexes(NULL)
+    coefficients(NULL), indexes(NULL), radius_cache(0), owned(true)
 {
 }
 
 
 // Says highest symbol in use is val
 
-inline void AAF:: set_default(const unsigned val) {
+inline void AAF:: set_default(const aa_symbol val) {
     last=val;
 }
 
 
 // Increment the highest symbol in use
 // i.e. create a new noise symbol
+// (atomic, so that threads computing on their own AAFs
+// never get the same symbol)
+// The symbols of the block given to this thread come first
+
+inline aa_symbol AAF:: inclast() {
+    if (block_next != block_end)
+        return block_next++;
+    if (block_end)
+        block_out = true;
+    return __sync_add_and_fetch(&last, 1);
+}
+
 
-inline unsigned AAF:: inclast() {
-    return ++last;
+// Move the highest symbol in use up to s if it is below
+
+inline void AAF:: reserve(aa_symbol s) {
+    aa_symbol l = last;
+    while (l < s) {
+        const aa_symbol seen = __sync_val_compare_and_swap(&last, l, s);
+        if (seen == l)
+            break;
+        l = seen;
+    }
+}
+
+
+// Says if the fast mode is on
+
+inline bool AAF:: fast_mode() {
+    return fast;
 }
 
 
@@ -176,15 +276,16 @@ inline unsigned AAF::get_length() const {
     return length;
 }
 
+// The special flags are kept up to date by the constructors
+// and the operators (any infinite coefficient sets AAF_TYPE_INFINITE)
+// so these tests don't need to look at the coefficients
+
 inline bool AAF::is_indeterminate() const {
-    if(special & AAF_TYPE_INFINITE) return 1;
-    if(special & AAF_TYPE_NAN) return 1;
-    return rad() == HUGE_VAL;
+    return (special & (AAF_TYPE_INFINITE | AAF_TYPE_NAN)) != 0;
 }
 
 inline bool AAF::is_infinite() const {
-    if(special & AAF_TYPE_INFINITE) return 1;
-    return rad() == HUGE_VAL;
+    return (special & AAF_TYPE_INFINITE) != 0;
 }
 
 inline bool AAF::is_nan() const {
@@ -203,6 +304,152 @@ inline bool AAF::strictly_neg() const {
 }
 
 
+// Read-only view of an AAF stored elsewhere
+// (e.g. in a mmap'd file of coefficients and indexes arrays)
+// Nothing is copied : the arrays must live longer than the view,
+// the indexes must be sorted and the coefficients non zero
+// A view can be used wherever a const AAF is expected, the results
+// of the operations are plain AAFs
+//
+//   AAFView v(c0, coeffs, idx, n);
+//   AAF z = x*v + v;
+
+class AAFView
+{
+
+private:
+    AAF form;
+
+public:
+    AAFView(double v0, const double * t1, const aa_symbol * t2, unsigned T,
+            AAF_TYPE t = AAF_TYPE_AFFINE);
+    AAFView(const AAFView & V);
+
+    AAFView & operator = (const AAFView & V);
+
+    operator const AAF & () const;
+    const AAF & get_form() const;
+
+    unsigned get_length() const;
+    double get_center() const;
+    double get_coeff(unsigned i) const;
+    aa_symbol get_index(unsigned i) const;
+    double index_coeff(aa_symbol index) const;
+    double rad() const;
+    interval convert() const;
+    AAF_TYPE get_special() const;
+};
+
+// The view as left operand
+
+AAF operator + (const AAFView & V, const AAF & P);
+AAF operator - (const AAFView & V, const AAF & P);
+AAF operator * (const AAFView & V, const AAF & P);
+AAF operator / (const AAFView & V, const AAF & P);
+AAF operator * (const AAFView & V, double cst);
+
+
+// AAFView inline functions
+
+inline AAFView::AAFView(double v0, const double * t1, const aa_symbol * t2, unsigned T,
+                        AAF_TYPE t)
+{
+    form.alias(v0, t1, t2, T, t);
+}
+
+
+// A copy is another view of the same arrays
+
+inline AAFView::AAFView(const AAFView & V)
+{
+    form.alias(V.form.cvalue, V.form.coefficients, V.form.indexes, V.form.length,
+               V.form.special);
+}
+
+
+inline AAFView & AAFView::operator = (const AAFView & V) {
+    if (&V != this)
+        form.alias(V.form.cvalue, V.form.coefficients, V.form.indexes, V.form.length,
+                   V.form.special);
+    return *this;
+}
+
+
+inline AAFView::operator const AAF & () const {
+    return form;
+}
+
+
+inline const AAF & AAFView::get_form() const {
+    return form;
+}
+
+
+inline unsigned AAFView::get_length() const {
+    return form.get_length();
+}
+
+
+inline double AAFView::get_center() const {
+    return form.cvalue;
+}
+
+
+inline double AAFView::get_coeff(unsigned i) const {
+    return form.get_coeff(i);
+}
+
+
+inline aa_symbol AAFView::get_index(unsigned i) const {
+    return form.get_index(i);
+}
+
+
+inline double AAFView::index_coeff(aa_symbol index) const {
+    return form.index_coeff(index);
+}
+
+
+inline double AAFView::rad() const {
+    return form.rad();
+}
+
+
+inline interval AAFView::convert() const {
+    return form.convert();
+}
+
+
+inline AAF_TYPE AAFView::get_special() const {
+    return form.special;
+}
+
+
+inline AAF operator + (const AAFView & V, const AAF & P) {
+    return V.get_form() + P;
+}
+
+
+inline AAF operator - (const AAFView & V, const AAF & P) {
+    return V.get_form() - P;
+}
+
+
+inline AAF operator * (const AAFView & V, const AAF & P) {
+    return V.get_form()*P;
+}
+
+
+inline AAF operator / (const AAFView & V, const AAF & P) {
+    return V.get_form()/P;
+}
+
+
+inline AAF operator * (const AAFView & V, double cst) {
+    return V.get_form()*cst;
+}
+
+
 #endif  // AA_AAF_H
 /*
   Local Variables:
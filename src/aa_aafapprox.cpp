@@ -24,80 +24,125 @@
 
 #include "aa.h"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 
+#include "aa_table.h"
 #include "aa_util.h"
 
 
+// Coefficients of P * Q for aa_merge() : the linear part of
+// (x0 + x) * (y0 + y) is y0*x + x0*y
+
+struct aaf_mul_op {
+    enum { copy_first = 0, copy_second = 0 };
+    aa_roundoff & ro;
+    double x0, y0;
+    bool ovf;
+
+    aaf_mul_op(aa_roundoff & r, double x, double y) : ro(r), x0(x), y0(y), ovf(false) {}
+
+    double check(double c) {
+        ovf |= (fabs(c) == HUGE_VAL);
+        return c;
+    }
+
+    double first(double x) { return check(ro.mul(y0, x)); }
+    double second(double y) { return check(ro.mul(x0, y)); }
+    double both(double x, double y) { return check(ro.add(ro.mul(x0, y), ro.mul(y0, x))); }
+};
+
+
 // Operator  *
 
 AAF AAF::operator * (const AAF & P) const {
+    AA_STAT_OP(AA_OP_MUL);
     unsigned l1 = length;
     unsigned l2 = P.length;
 
-    unsigned * id1 = indexes;
-    unsigned * id2 = P.indexes;
+    // The round-off errors (see aa_roundoff) are added to the error symbol
 
-    double * va1 = coefficients;
-    double * va2 = P.coefficients;
+    aa_roundoff ro;
 
-    unsigned * pu1 = id1;
-    unsigned * pu2 = id2;
+    AAF Temp(ro.mul(cvalue, P.cvalue));
+    Temp.radius_cache = -1;
 
-    AAF Temp(cvalue*P.cvalue);  // Create our resulting AAF
+    Temp.indexes = new aa_symbol [l1+l2+1];
+    Temp.coefficients = new double [l1+l2+1];
+    AA_STAT_ALLOC(2);
 
-    Temp.indexes = new unsigned [l1+l2+1];
-    unsigned * idtemp=Temp.indexes;
 
+    // Fill the coefficients array (see aa_merge)
+    // keeping track of any overflow
 
-    // Fill the indexes array
+    aaf_mul_op op(ro, cvalue, P.cvalue);
+    unsigned ltemp = aa_merge(indexes, coefficients, l1, P.indexes, P.coefficients, l2,
+                              Temp.indexes, Temp.coefficients, op);
+    bool ovf = op.ovf;
 
-    unsigned * fin = std::set_union(id1,id1+l1,id2,id2+l2,idtemp);
-    unsigned ltemp=fin-idtemp;
+    Temp.length = ltemp+1;
 
-    Temp.coefficients = new double [ltemp+1];
-    double * vatempg=Temp.coefficients;
 
-    Temp.length = ltemp+1;
+    // Compute the error
+    // in a new noise symbol
 
+    Temp.indexes[ltemp]=inclast();
+    // (rad() sums length positive terms)
 
-    // Fill the coefficients array
+    Temp.coefficients[ltemp]=ro.error(rad()*(P.rad()), l1+l2+1);
+    AA_STAT_SYMBOL();
+    AA_STAT_ERROR(Temp.coefficients[ltemp]);
+    AA_TAG_SYMBOL(Temp.indexes[ltemp], NULL);
+    ovf |= (Temp.coefficients[ltemp] == HUGE_VAL);
 
-    for (unsigned i = 0; i < ltemp; i++)
-    {
-        unsigned a = pu1-id1;
-        unsigned b = pu2-id2;
+    Temp.special = binary_special(special, P.special);
+    if (ovf)
+        Temp.special = (AAF_TYPE)(Temp.special | AAF_TYPE_INFINITE);
 
-        if (a==l1 || id1[a]!=idtemp[i])
-        {
-            vatempg[i] = cvalue*va2[b];  // cvalue*va2[b]+(P.cvalue)*0
-            pu2++;
-            continue;
-        }
+    AA_STAT_FORM(Temp.length);
+    return Temp;
 
-        if (b==l2 || id2[b]!=idtemp[i])
-        {
-            vatempg[i] = (P.cvalue)*va1[a];  // cvalue*0+(P.cvalue)*va1[a]
-            pu1++;
-            continue;
-        }
+}
 
-        vatempg[i] = cvalue*va2[b] + (P.cvalue)*va1[a];
-        pu1++;
-        pu2++;
-    }
 
+// Dot product of P[0] ... P[n-1] and Q[0] ... Q[n-1]
+// Each product is linearized as in operator * but the errors
+// are summed in a single new noise symbol
 
-    // Compute the error
-    // in a new noise symbol
+AAF aaf_dot(const AAF * P, const AAF * Q, unsigned n) {
+    AA_STAT_OP(AA_OP_DOT);
+    if (n == 0)
+        return AAF(0.);
 
-    Temp.indexes[ltemp]=inclast();
-    Temp.coefficients[ltemp]=rad()*(P.rad());
+    const AAF ** f = new const AAF * [2*n];
+    double * scale = new double [2*n];
+    AA_STAT_ALLOC(2);
 
-    Temp.special = binary_special(special, P.special);
+    aa_roundoff ro;  // round-off of v0
+    unsigned k = 0;  // operations made for delta
 
-    return Temp;
+    double v0 = 0;
+    double delta = 0;
+    AAF_TYPE type = binary_special(P[0].special, Q[0].special);
+
+    for (unsigned i = 0; i < n; i++) {
+        f[2*i] = &P[i];
+        scale[2*i] = Q[i].cvalue;
+        f[2*i+1] = &Q[i];
+        scale[2*i+1] = P[i].cvalue;
+
+        v0 = ro.add(v0, ro.mul(P[i].cvalue, Q[i].cvalue));
+        delta += P[i].rad()*Q[i].rad();
+        k += P[i].length + Q[i].length + 2;
+        type = binary_special(type, binary_special(P[i].special, Q[i].special));
+    }
+
+    AAF Temp = AAF::merge(2*n, f, scale, v0, type, true, ro.error(delta, k));
 
+    delete [] scale;
+    delete [] f;
+
+    return Temp;
 }
 
 
@@ -106,15 +151,64 @@ AAF AAF::operator * (const AAF & P) const {
 // We use the identity x/y = x * (1/y)
 
 AAF AAF::operator / (const AAF & P) const {
+    AA_STAT_OP(AA_OP_DIV);
     return (*this)*inv(P);
 }
 
 
+// A line alpha*x + dzeta within delta of a convex f on [a,b], whatever
+// the round-off (in an aa_rounding_scope or with AA_RIGOROUS) :
+// fa and fb enclose f(a) and f(b), ft and dt enclose f(t) and f'(t)
+// at a point t of [a,b] (the one where f'(t) = alpha is best)
+// g(x) = f(x) - alpha*x is convex, so it is at most max(g(a), g(b))
+// and at least the tangent of f at t minus alpha*x, whose minimum on
+// [a,b] is at a or at b ; these bounds are computed with the outward
+// rounded interval operations
+
+static void bound_convex(double alpha, double a, double b,
+                         const interval & fa, const interval & fb,
+                         double t, const interval & ft, const interval & dt,
+                         double & dzeta, double & delta)
+{
+    const double hi = std::max((fa - interval(alpha)*a).right(),
+                               (fb - interval(alpha)*b).right());
+
+    const interval c = ft - dt*t;           // the tangent is c + dt*x
+    const interval s = dt - interval(alpha);
+    const double lo = std::min((c + s*a).left(), (c + s*b).left());
+
+    dzeta = lo/2 + hi/2;
+    delta = std::max(aa_round_up(hi - dzeta), aa_round_up(dzeta - lo));
+}
+
+// The same for a concave f, from the convex -f
+
+static void bound_concave(double alpha, double a, double b,
+                          const interval & fa, const interval & fb,
+                          double t, const interval & ft, const interval & dt,
+                          double & dzeta, double & delta)
+{
+    bound_convex(-alpha, a, b, -fa, -fb, t, -ft, -dt, dzeta, delta);
+    dzeta = -dzeta;
+}
+
+// t moved into [a,b]
+
+static double clamp(double t, double a, double b) {
+    if (!(t >= a))
+        return a;
+    if (!(t <= b))
+        return b;
+    return t;
+}
+
+
 // Square root operator
 // It's a non affine-operation
 // We use the Chebyshev approximation
 
 AAF sqrt(const AAF & P) {
+    AA_STAT_OP(AA_OP_SQRT);
     handle_infinity(P);
     // sqrt(x) is approximated by f(x)=alpha*x+dzeta
     // delta is the maximum absolute error
@@ -130,17 +224,36 @@ AAF sqrt(const AAF & P) {
         type = (AAF_TYPE)(AAF_TYPE_AFFINE | AAF_TYPE_NAN);
     //type = (AAF_TYPE)(type | P.special);
 
-    const double t = (sqrt(a)+sqrt(b));
+    if (aa_roundoff().active()) {
+        // the tangent point of the Chebyshev line is ((sa+sb)/2)^2
+
+        const double a0 = std::max(a, 0.);
+        if (b <= 0)
+            return AAF(P, 0, 0, 0, type);
+        const double sa = sqrt(a0);
+        const double sb = sqrt(b);
+        const double alpha = 1/(sa+sb);
+        const double t = clamp((sa+sb)*(sa+sb)/4, a0, b);
+        const interval ft = sqrt(interval(t));
+        double dzeta, delta;
+        bound_concave(alpha, a0, b, sqrt(interval(a0)), sqrt(interval(b)),
+                      t, ft, interval(0.5)/ft, dzeta, delta);
+        return AAF(P, alpha, dzeta, delta, type);
+    }
+
+    const double sa = sqrt(a);
+    const double sb = sqrt(b);
+    const double t = (sa+sb);
 
 
     const double alpha = 1/t; // alpha is the slope of the line r(x) that
     // interpolate (a, sqrt(a)) and (b, f(b))
 
     // dzeta calculation:
-    const double dzeta = (t/8)+0.5*(sqrt(a*b))/t;
+    const double dzeta = (t/8)+0.5*(sa*sb)/t;
 
     // Calculation of the error
-    const double rdelta = (sqrt(b)-sqrt(a));
+    const double rdelta = (sb-sa);
     const double delta = rdelta*rdelta/(8*t);
 
     return AAF(P, alpha, dzeta, delta, type);
@@ -153,6 +266,7 @@ AAF sqrt(const AAF & P) {
 // because undershoot can be high with Chebyshev here
 
 AAF inv(const AAF & P) {
+    AA_STAT_OP(AA_OP_INV);
     handle_infinity(P);
     double a = P.convert().left();
     double b = P.convert().right();
@@ -170,6 +284,16 @@ AAF inv(const AAF & P) {
 
     const double alpha=-1/(b*b);
 
+    if (aa_roundoff().active()) {
+        // the slope is the one at b
+
+        const interval fb = inv(interval(b));
+        double dzeta, delta;
+        bound_convex(alpha, a, b, inv(interval(a)), fb, b, fb, -sqr(fb), dzeta, delta);
+        if ((P.convert().left()) < 0) dzeta = -dzeta;
+        return AAF(P, alpha, dzeta, delta, P.special);
+    }
+
     interval i((1/a)-alpha*a, 2/b);//-alpha*b);
     double dzeta = i.mid();
 
@@ -179,12 +303,14 @@ AAF inv(const AAF & P) {
 }
 
 AAF abs(const AAF & P) {
+    AA_STAT_OP(AA_OP_ABS);
     if(P.strictly_neg())
         return -P;
     if(P.straddles_zero()) {
         AAF Temp(P);
         Temp.cvalue = fabs(Temp.cvalue)/2;
         Temp.special = P.special;
+        Temp.radius_cache = -1;
 
         for (unsigned i=0; i<P.length; i++)
             Temp.coefficients[i]=(Temp.coefficients[i])/2;
@@ -194,6 +320,7 @@ AAF abs(const AAF & P) {
 }
 
 AAF sqr(const AAF & P) {
+    AA_STAT_OP(AA_OP_SQR);
     return P*P;
 }
 
@@ -201,6 +328,7 @@ AAF sqr(const AAF & P) {
 // only for integer exponents
 
 AAF pow(const AAF & P, int exp) {
+    AA_STAT_OP(AA_OP_POW_INT);
     handle_infinity(P);
     if (exp == 0) {
         return 1;
@@ -214,14 +342,137 @@ AAF pow(const AAF & P, int exp) {
     }
 }
 
+// x^p for a scalar x > 0
+// The common fractional exponents avoid the generic libm pow()
+
+static double pow_scalar(double x, double p) {
+    if (p == 0.5)
+        return sqrt(x);
+    if (p == -0.5)
+        return 1/sqrt(x);
+    if (p == 1.0/3)
+        return cbrt(x);
+    if (p == -1.0/3)
+        return 1/cbrt(x);
+    if (p == 1.5)
+        return x*sqrt(x);
+    if (p == 0.25)
+        return sqrt(sqrt(x));
+    if (p == 2.0/3) {
+        const double c = cbrt(x);
+        return c*c;
+    }
+    if (p == -1)
+        return 1/x;
+    if (p == 2)
+        return x*x;
+    if (p == -2)
+        return 1/(x*x);
+    return pow(x, p);
+}
+
+
+// Power function
+// for real exponents
+// x^p is convex for p < 0 or p > 1 and concave for 0 < p < 1
+// We use the Chebyshev approximation except for p < 0
+// where we use mini-range as the Chebyshev line can go negative
+// (see inv())
+
 AAF pow(const AAF & P, double xp) {
-    return exp(xp*log(P));
+    AA_STAT_OP(AA_OP_POW);
+    handle_infinity(P);
+
+    if (xp == 0)
+        return 1;
+    if (xp == 1)
+        return P;
+    if (xp == 0.5)
+        return sqrt(P);
+
+    // Integer exponents are defined on the whole real line
+
+    if ((xp == floor(xp)) && (fabs(xp) <= 1024))
+        return pow(P, (int)xp);
+
+    const interval i = P.convert();
+    double a = i.left(); // [a,b] is our interval
+    const double b = i.right();
+
+    AAF_TYPE type = AAF_TYPE_AFFINE;
+    if (b < 0)
+        return AAF(AAF_TYPE_NAN);
+    if (a < 0) { // partly undefined, we keep the defined part
+        type = (AAF_TYPE)(AAF_TYPE_AFFINE | AAF_TYPE_NAN);
+        a = 0;
+    }
+
+    if ((xp < 0) && (a == 0))
+        return AAF(interval(-HUGE_VAL, HUGE_VAL));
+
+    const double fa = pow_scalar(a, xp);
+    const double fb = pow_scalar(b, xp);
+
+    if (aa_roundoff().active()) {
+        // the same slopes and tangent points as below
+        // (x^p is convex for p < 0 or p > 1)
+
+        double alpha = 0;
+        if (xp < 0)
+            alpha = xp*fb/b;
+        else if (b > a)
+            alpha = (fb-fa)/(b-a);
+        const double t = clamp((xp < 0) ? b : pow_scalar(alpha/xp, 1/(xp-1)), a, b);
+
+        const interval ft = pow(interval(t), xp);
+        const interval dt = interval(xp)*pow(interval(t), xp - 1);
+        double dzeta, delta;
+        if ((xp < 0) || (xp > 1))
+            bound_convex(alpha, a, b, pow(interval(a), xp), pow(interval(b), xp),
+                         t, ft, dt, dzeta, delta);
+        else
+            bound_concave(alpha, a, b, pow(interval(a), xp), pow(interval(b), xp),
+                          t, ft, dt, dzeta, delta);
+        return AAF(P, alpha, dzeta, delta, type);
+    }
+
+    if (b == a)
+        return AAF(P, 0, fa, 0, type);
+
+    double alpha, dzeta, delta;
+
+    if (xp < 0) {
+        // mini-range : the slope at b, where |f'| is minimal
+        // f(x) - alpha*x is then decreasing on [a,b]
+
+        alpha = xp*fb/b;
+
+        interval r(fb - alpha*b, fa - alpha*a);
+        dzeta = r.mid();
+        delta = r.radius();
+    } else {
+        // alpha is the slope of the line r(x) that
+        // interpolate (a, f(a)) and (b, f(b))
+
+        alpha = (fb-fa)/(b-a);
+
+        // u is the x of the maximum error, i.e. f'(u) = alpha
+
+        const double u = pow_scalar(alpha/xp, 1/(xp-1));
+        const double d = pow_scalar(u, xp) - (fa + alpha*(u-a));
+
+        dzeta = fa - alpha*a + d/2;
+        delta = fabs(d)/2;
+    }
+
+    return AAF(P, alpha, dzeta, delta, type);
 }
 
 // Exponential operator
 // It's a non affine-operation
 
 AAF exp(const AAF & P) {
+    AA_STAT_OP(AA_OP_EXP);
     handle_infinity(P); // infinity maps to [0, infty) here
     // exp(x) is approximated by f(x)=alpha*x+dzeta
     // delta is the maximum absolute error
@@ -229,6 +480,33 @@ AAF exp(const AAF & P) {
     const double a = P.convert().left(); // [a,b] is our interval
     const double b = P.convert().right();
 
+    const bool bounded = aa_roundoff().active();
+
+    interval ia;
+    if (!bounded && AAF::fast_mode() && (b - a <= AA_NARROW_WIDTH) && aa_exp_bound(a, ia)) {
+        // Everything follows from exp(a) with u = b-a :
+        // the slope of the secant is exp(a)*s(u), s(u) = (exp(u)-1)/u
+        // the tangent with this slope is at a+t(u), t(u) = log(s(u))
+        // the max error is exp(a)*g(u), g(u) = 1-s(u)+s(u)*t(u)
+        // We use the Taylor series of s, t and g
+
+        const double u = b - a;
+        const double s = 1 + u*(1./2 + u*(1./6 + u*(1./24 + u*(1./120 + u/720))));
+        const double t = u*(1./2 + u*(1./24 - u*u/2880));
+        const double g = u*u*(1./8 + u*(1./16 + u*(11./576 + u/200)));
+
+        const double ea = (ia.left() + ia.right())/2;
+        const double alpha = ea*s;
+        const double maxdelta = ea*g;
+
+        // the uncertainty on exp(a) goes in the error
+
+        const double delta = maxdelta/2 + (ia.width() + DBL_EPSILON*ea*u)*(1 + u);
+        const double dzeta = alpha*(1 - a - t) + maxdelta/2;
+
+        return AAF(P, alpha, dzeta, delta, P.special);
+    }
+
     const double ea = exp(a);
     const double eb = exp(b);
     if ((ea == HUGE_VAL) || (eb == HUGE_VAL)) {
@@ -239,18 +517,29 @@ AAF exp(const AAF & P) {
         return AAF(interval(-HUGE_VAL, HUGE_VAL));
     }
 
-    const double alpha = (eb-ea)/(b-a);
+    const double alpha = (b > a) ? (eb-ea)/(b-a) : ea;
     // alpha is the slope of the line r(x) that
     // interpolate (a, exp(a)) and (b, exp(b))
     const double xs = log(alpha);// the x of the maximum error
-    const double maxdelta = alpha*(xs - 1 - a)+ea;
 
-    // dzeta calculation:
-    const double dzeta = alpha*(1 - xs);
+    if (bounded) {
+        const double t = clamp(xs, a, b);
+        const interval et = exp(interval(t));
+        double dzeta, delta;
+        bound_convex(alpha, a, b, exp(interval(a)), exp(interval(b)), t, et, et,
+                     dzeta, delta);
+        return AAF(P, alpha, dzeta, delta, P.special);
+    }
+    const double maxdelta = alpha*(xs - 1 - a)+ea;
 
     // Calculation of the error
     const double delta = maxdelta/2;
 
+    // dzeta calculation:
+    // alpha*x + alpha*(1 - xs) is the tangent at xs, exp(x) is
+    // above it so we move up the line by half the max error
+    const double dzeta = alpha*(1 - xs) + delta;
+
     return AAF(P, alpha, dzeta, delta, P.special);
 }
 
@@ -258,6 +547,7 @@ AAF exp(const AAF & P) {
 // It's a non affine-operation
 
 AAF log(const AAF & P) {
+    AA_STAT_OP(AA_OP_LOG);
     handle_infinity(P); // infinity needs to map to NaN here
 
     const double a = P.convert().left(); // [a,b] is our interval
@@ -276,13 +566,47 @@ AAF log(const AAF & P) {
         // perhaps we should make a = 0+eps and try to continue?
     }
 
+    const bool bounded = aa_roundoff().active();
+
+    interval ia;
+    if (!bounded && AAF::fast_mode() && (b - a <= AA_NARROW_WIDTH*a) && aa_log_bound(a, ia)) {
+        // Everything follows from log(a) with r = (b-a)/a :
+        // the slope of the secant is (1-e)/a, 1-e = log(1+r)/r
+        // the tangent with this slope is at a/(1-e)
+        // and the max error is -log(1-e) - e
+        // We use the Taylor series of e and of the max error
+
+        const double r = (b - a)/a;
+        const double e = r*(1./2 - r*(1./3 - r*(1./4 - r*(1./5 - r*(1./6
+                                                              - r*(1./7 - r/8))))));
+        const double maxdelta = e*e*(1./2 + e*(1./3 + e*(1./4 + e*(1./5 + e/3))));
+
+        const double la = (ia.left() + ia.right())/2;
+        const double alpha = (1 - e)/a;
+
+        // the uncertainty on log(a) goes in the error
+
+        const double delta = maxdelta/2 + ia.width() + DBL_EPSILON*(r + fabs(la));
+        const double dzeta = la - 1 + e + maxdelta/2;
+
+        return AAF(P, alpha, dzeta, delta, type);
+    }
+
     const double la = log(a);
     const double lb = log(b);
 
-    const double alpha = (lb-la)/(b-a);
+    const double alpha = (b > a) ? (lb-la)/(b-a) : 1/a;
     // alpha is the slope of the line r(x) that
-    // interpolate (a, exp(a)) and (b, exp(b))
+    // interpolate (a, log(a)) and (b, log(b))
     const double xs = 1/(alpha);// the x of the maximum error
+
+    if (bounded) {
+        const double t = clamp(xs, a, b);
+        double dzeta, delta;
+        bound_concave(alpha, a, b, log(interval(a)), log(interval(b)),
+                      t, log(interval(t)), inv(interval(t)), dzeta, delta);
+        return AAF(P, alpha, dzeta, delta, type);
+    }
     const double ys = (alpha*(xs - a)+la);
     const double maxdelta = log(xs) - ys;
 
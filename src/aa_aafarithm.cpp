@@ -24,76 +24,83 @@
 
 #include "aa.h"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <stdio.h>
 
 #include "aa_util.h"
 
+// Coefficients of P + Q and P - Q for aa_merge()
+
+struct aaf_add_op {
+    enum { copy_first = 1, copy_second = 1 };
+    aa_roundoff & ro;
+    bool ovf;
+
+    aaf_add_op(aa_roundoff & r) : ro(r), ovf(false) {}
+
+    double first(double x) { return x; }    // x+0
+    double second(double y) { return y; }   // 0+y
+    double both(double x, double y) {
+        const double c = ro.add(x, y);
+        ovf |= (fabs(c) == HUGE_VAL);
+        return c;
+    }
+};
+
+struct aaf_sub_op {
+    enum { copy_first = 1, copy_second = 0 };
+    aa_roundoff & ro;
+    bool ovf;
+
+    aaf_sub_op(aa_roundoff & r) : ro(r), ovf(false) {}
+
+    double first(double x) { return x; }    // x-0
+    double second(double y) { return -y; }  // 0-y
+    double both(double x, double y) {
+        const double c = ro.add(x, -y);
+        ovf |= (fabs(c) == HUGE_VAL);
+        return c;
+    }
+};
+
+
 // Operator +
 // Addition is an affine operation
 
 AAF AAF::operator + (const AAF & P) const {
+    AA_STAT_OP(AA_OP_ADD);
     //handle_infinity(P);
     //handle_infinity(*this);
     unsigned l1 = length;
     unsigned l2 = P.length;
 
-    unsigned * id1=indexes;
-    unsigned * id2=P.indexes;
+    // The round-off errors (see aa_roundoff) end in a new noise symbol
 
-    double * va1=coefficients;
-    double * va2=P.coefficients;
+    aa_roundoff ro;
 
-    unsigned * pu1=id1;
-    unsigned * pu2=id2;
-
-    AAF Temp(cvalue+P.cvalue);  // Create our resulting AAF
+    AAF Temp(ro.add(cvalue, P.cvalue));
+    Temp.radius_cache = -1;
 
     Temp.special = binary_special(special, P.special);
 
-    Temp.indexes = new unsigned [l1+l2]; // the indexes of the result
-    unsigned * idtemp=Temp.indexes;
-
-
-    // Fill the resulting indexes array
-    // by merging the 2 input indexes array
-
-    unsigned * fin = std::set_union(id1,id1+l1,id2,id2+l2,idtemp);
-    unsigned ltemp=fin-idtemp;
-
-    Temp.coefficients = new double [ltemp];
-    double * vatempg=Temp.coefficients;
-
-    Temp.length = ltemp;
+    Temp.indexes = new aa_symbol [l1+l2+1]; // the indexes of the result
+    Temp.coefficients = new double [l1+l2+1];
+    AA_STAT_ALLOC(2);
 
 
-    // Fill the coefficients array
-    // of the resulting AAF
+    // Merge the 2 lists of terms (see aa_merge)
 
-    for (unsigned i=0;i<ltemp;i++)
-    {
-        unsigned a=pu1-id1;
-        unsigned b=pu2-id2;
+    aaf_add_op op(ro);
+    Temp.length = aa_merge(indexes, coefficients, l1, P.indexes, P.coefficients, l2,
+                           Temp.indexes, Temp.coefficients, op);
+    if (op.ovf)
+        Temp.special = (AAF_TYPE)(Temp.special | AAF_TYPE_INFINITE);
 
-        if (a==l1|| id1[a]!=idtemp[i])
-        {
-            vatempg[i]=va2[b];  // va2[b]+0
-            pu2++;
-            continue;
-        }
-
-        if (b==l2 || id2[b]!=idtemp[i])
-        {
-            vatempg[i]=va1[a];  // va1[a]+0
-            pu1++;
-            continue;
-        }
-
-        vatempg[i]=va1[a]+va2[b];
-        pu1++;
-        pu2++;
-    }
+    if (ro.active() && ro.error() > 0)
+        Temp.add_error(ro.error());
 
+    AA_STAT_FORM(Temp.length);
     return Temp;
 }
 
@@ -101,68 +108,34 @@ AAF AAF::operator + (const AAF & P) const {
 // Operator -
 
 AAF AAF::operator - (const AAF & P) const {
+    AA_STAT_OP(AA_OP_SUB);
     //handle_infinity(P);
     //handle_infinity(*this);
 
     unsigned l1 = length;
     unsigned l2 = P.length;
 
-    unsigned * id1=indexes;
-    unsigned * id2=P.indexes;
+    aa_roundoff ro;
 
-    double * va1=coefficients;
-    double * va2=P.coefficients;
-
-    unsigned * pu1=id1;
-    unsigned * pu2=id2;
-
-    AAF Temp(cvalue-P.cvalue);  // Create our resulting AAF
+    AAF Temp(ro.add(cvalue, -P.cvalue));
+    Temp.radius_cache = -1;
 
     Temp.special = binary_special(special, P.special);
 
-    Temp.indexes = new unsigned [l1+l2];
-    unsigned * idtemp=Temp.indexes;
-
-
-    // Fill the resulting indexes array
-    // by merging the 2 input indexes array
-
-    unsigned * fin = std::set_union(id1,id1+l1,id2,id2+l2,idtemp);
-    unsigned ltemp=fin-idtemp;
-
-    Temp.coefficients = new double [ltemp];
-    double * vatempg=Temp.coefficients;
-
-    Temp.length = ltemp;
-
-
-    // Fill the coefficients array
-    // of the resulting AAF
-
-    for (unsigned i=0;i<ltemp;i++)
-    {
-        unsigned a=pu1-id1;
-        unsigned b=pu2-id2;
-
-        if (a==l1|| id1[a]!=idtemp[i])
-        {
-            vatempg[i]=-va2[b];  // 0-va2[b]
-            pu2++;
-            continue;
-        }
+    Temp.indexes = new aa_symbol [l1+l2+1];
+    Temp.coefficients = new double [l1+l2+1];
+    AA_STAT_ALLOC(2);
 
-        if (b==l2 || id2[b]!=idtemp[i])
-        {
-            vatempg[i]=va1[a];  // va1[a]-0
-            pu1++;
-            continue;
-        }
+    aaf_sub_op op(ro);
+    Temp.length = aa_merge(indexes, coefficients, l1, P.indexes, P.coefficients, l2,
+                           Temp.indexes, Temp.coefficients, op);
+    if (op.ovf)
+        Temp.special = (AAF_TYPE)(Temp.special | AAF_TYPE_INFINITE);
 
-        vatempg[i]=va1[a]-va2[b];
-        pu1++;
-        pu2++;
-    }
+    if (ro.active() && ro.error() > 0)
+        Temp.add_error(ro.error());
 
+    AA_STAT_FORM(Temp.length);
     return Temp;
 
 }
@@ -172,6 +145,7 @@ AAF AAF::operator - (const AAF & P) const {
 
 AAF AAF::operator - () const
 {
+    AA_STAT_OP(AA_OP_NEG);
     AAF Temp(*this);
     Temp.special = special;
 
@@ -179,6 +153,7 @@ AAF AAF::operator - () const
     for (unsigned i=0; i<length; i++)
         Temp.coefficients[i]=-(Temp.coefficients[i]);
 
+    AA_STAT_FORM(Temp.length);
     return Temp;
 
 }
@@ -189,15 +164,149 @@ AAF AAF::operator - () const
 
 AAF AAF::operator * (const double cst) const
 {
+    AA_STAT_OP(AA_OP_SCALE);
+    aa_roundoff ro;
+
     AAF Temp(*this);
-    Temp.cvalue=cst*cvalue;
+    Temp.cvalue = ro.mul(cst, cvalue);
     Temp.special = special;
+    Temp.radius_cache = -1;
+
+    for (unsigned i=0; i<length; i++) {
+        Temp.coefficients[i] = ro.mul(cst, Temp.coefficients[i]);
+        if (fabs(Temp.coefficients[i]) == HUGE_VAL) // overflow
+            Temp.special = (AAF_TYPE)(Temp.special | AAF_TYPE_INFINITE);
+    }
+
+    if (ro.active() && ro.error() > 0) {
+        // Temp has no room for the error symbol
+
+        AAF Res(Temp.cvalue);
+        Res.special = Temp.special;
+        Res.length = length;
+        Res.indexes = new aa_symbol [length+1];
+        Res.coefficients = new double [length+1];
+        AA_STAT_ALLOC(2);
+        std::copy(Temp.indexes, Temp.indexes+length, Res.indexes);
+        std::copy(Temp.coefficients, Temp.coefficients+length, Res.coefficients);
+        Res.add_error(ro.error());
+        AA_STAT_FORM(Res.length);
+        return Res;
+    }
+
+    AA_STAT_FORM(Temp.length);
+    return Temp;
+
+}
+
+
+// Append the noise symbol of a round-off error
+// The arrays must have room for it
 
+void AAF::add_error(double err) {
+    AA_STAT_SYMBOL();
+    indexes[length] = inclast();
+    AA_TAG_SYMBOL(indexes[length], NULL);
+    coefficients[length] = err;
+    length++;
+    radius_cache = -1;
+}
+
+
+// sign*P + cst for sign = 1 or -1 : only the center is rounded
+// A constant plus a constant allocates nothing, unless the sum is
+// rounded and its error put in a new noise symbol
+
+AAF AAF::shift(double sign, double cst) const
+{
+    AA_STAT_OP(AA_OP_SHIFT);
+    aa_roundoff ro;
+
+    AAF Temp(ro.add(sign*cvalue, cst));
+    Temp.special = special;
+    if (fabs(Temp.cvalue) == HUGE_VAL)
+        Temp.special = (AAF_TYPE)(Temp.special | AAF_TYPE_INFINITE);
+
+    // (room for the error symbol only when there is an error)
+
+    const bool err = ro.active() && ro.error() > 0;
+    const unsigned l = length + (err ? 1 : 0);
+    if (l == 0)
+        return Temp;
+
+    Temp.indexes = new aa_symbol [l];
+    Temp.coefficients = new double [l];
+    AA_STAT_ALLOC(2);
+    Temp.length = length;
+    std::copy(indexes, indexes+length, Temp.indexes);
     for (unsigned i=0; i<length; i++)
-        Temp.coefficients[i]=cst*(Temp.coefficients[i]);
+        Temp.coefficients[i] = sign*coefficients[i];
 
+    if (err)
+        Temp.add_error(ro.error());
+    else
+        Temp.radius_cache = radius_cache;  // same terms
+
+    AA_STAT_FORM(Temp.length);
     return Temp;
+}
+
 
+// Add a constant (on right)
+
+AAF AAF::operator + (const double cst) const {
+    return shift(1, cst);
+}
+
+
+// Sub a constant (on right)
+
+AAF AAF::operator - (const double cst) const {
+    return shift(1, -cst);
+}
+
+
+// Div by a constant (on right)
+// Each quotient is within one ulp, the sum of these errors goes
+// to the error symbol when the round-off is bounded
+
+AAF AAF::operator / (const double cst) const
+{
+    if (cst == 0)
+        return (*this)/AAF(cst);
+
+    AA_STAT_OP(AA_OP_DIV);
+    aa_roundoff ro;
+
+    AAF Temp(cvalue/cst);
+    Temp.special = special;
+    Temp.radius_cache = -1;
+
+    double delta = fabs(Temp.cvalue);
+    const unsigned l = length + (ro.active() ? 1 : 0);
+    if (l) {
+        Temp.indexes = new aa_symbol [l];
+        Temp.coefficients = new double [l];
+        AA_STAT_ALLOC(2);
+        Temp.length = length;
+        std::copy(indexes, indexes+length, Temp.indexes);
+    }
+
+    for (unsigned i=0; i<length; i++) {
+        Temp.coefficients[i] = coefficients[i]/cst;
+        delta += fabs(Temp.coefficients[i]);
+        if (fabs(Temp.coefficients[i]) == HUGE_VAL) // overflow
+            Temp.special = (AAF_TYPE)(Temp.special | AAF_TYPE_INFINITE);
+    }
+
+    if (ro.active()) {
+        const double err = ro.error(delta*DBL_EPSILON + (length+1)*AA_MIN_DENORM, length+1);
+        if (err > 0)
+            Temp.add_error(err);
+    }
+
+    AA_STAT_FORM(Temp.length);
+    return Temp;
 }
 
 
@@ -205,23 +314,253 @@ AAF AAF::operator * (const double cst) const
 
 // Mul by a constant (the left case)
 
-AAF operator * (const double cst, AAF P) {
-    AAF Temp(P);
-    return Temp*cst;
+AAF operator * (const double cst, const AAF & P) {
+    return P*cst;
 }
 
 
 // Add a constant (the left case)
 
-AAF operator + (const double cst, AAF P) {
-    return AAF(cst) + P;
+AAF operator + (const double cst, const AAF & P) {
+    return P + cst;
 }
 
 
 // Sub a constant (the left case)
 
-AAF operator - (const double cst, AAF P) {
-    return AAF(cst) - P;
+AAF operator - (const double cst, const AAF & P) {
+    return P.shift(-1, cst);
+}
+
+
+// Div a constant (the left case)
+
+AAF operator / (const double cst, const AAF & P) {
+    return inv(P)*cst;
+}
+
+
+// Merge of many AAFs at once
+// The result is f[0]*scale[0] + ... + f[n-1]*scale[n-1] + v0
+// (+ delta in a new noise symbol if error is set)
+// The round-off errors (see aa_roundoff) are added to delta
+// The indexes arrays are merged in a single pass :
+// if the indexes in use are dense enough, the coefficients
+// are accumulated in an array addressed by the index (bucket sort)
+// otherwise we use a heap of the lists, ordered by their current index
+// When the ranges of indexes don't overlap (e.g. independent inputs)
+// the lists are simply put one after the other
+
+struct aaf_merge_cmp {
+    const aa_symbol * const * id;
+    const unsigned * pos;
+
+    bool operator () (unsigned i, unsigned j) const {
+        return id[i][pos[i]] > id[j][pos[j]];
+    }
+};
+
+AAF AAF::merge(unsigned n, const AAF * const * f, const double * scale,
+               double v0, AAF_TYPE type, bool error, double delta)
+{
+    aa_roundoff ro;
+
+    unsigned total = (error || ro.active()) ? 1 : 0;
+    for (unsigned i = 0; i < n; i++)
+        total += f[i]->length;
+
+    AAF Temp(v0);  // Create our resulting AAF
+    Temp.radius_cache = -1;
+    Temp.special = type;
+
+    if (total == 0)
+        return Temp;
+
+    Temp.indexes = new aa_symbol [total];
+    Temp.coefficients = new double [total];
+    AA_STAT_ALLOC(2);
+
+    unsigned ltemp = 0;
+    bool ovf = false;
+
+    // Range of the indexes in use
+    // (ordered says if each range is after the ones before it)
+
+    aa_symbol lo = 0, hi = 0;
+    bool any = false;
+    bool ordered = true;
+    for (unsigned i = 0; i < n; i++) {
+        const unsigned l = f[i]->length;
+        if (!l)
+            continue;
+        if (any && f[i]->indexes[0] <= hi)
+            ordered = false;
+        if (!any || f[i]->indexes[0] < lo)
+            lo = f[i]->indexes[0];
+        if (!any || f[i]->indexes[l-1] > hi)
+            hi = f[i]->indexes[l-1];
+        any = true;
+    }
+
+    if (any && ordered) {
+        // no index in common, the lists are concatenated
+        for (unsigned i = 0; i < n; i++) {
+            const unsigned l = f[i]->length;
+            memcpy(Temp.indexes + ltemp, f[i]->indexes, l*sizeof(aa_symbol));
+            for (unsigned j = 0; j < l; j++) {
+                const double c = ro.mul(scale[i], f[i]->coefficients[j]);
+                Temp.coefficients[ltemp++] = c;
+                ovf |= (fabs(c) == HUGE_VAL);
+            }
+        }
+    } else if (any && (hi - lo < 2*total + 64)) {
+        const unsigned span = hi - lo + 1;
+        double * acc = new double [span];
+        bool * used = new bool [span];
+        AA_STAT_ALLOC(2);
+
+        for (unsigned k = 0; k < span; k++) {
+            acc[k] = 0;
+            used[k] = false;
+        }
+
+        for (unsigned i = 0; i < n; i++) {
+            const aa_symbol * id = f[i]->indexes;
+            const double * va = f[i]->coefficients;
+            for (unsigned j = 0; j < f[i]->length; j++) {
+                acc[id[j]-lo] = ro.add(acc[id[j]-lo], ro.mul(scale[i], va[j]));
+                used[id[j]-lo] = true;
+            }
+        }
+
+        for (unsigned k = 0; k < span; k++) {
+            if (!used[k])
+                continue;
+            Temp.indexes[ltemp] = k + lo;
+            Temp.coefficients[ltemp] = acc[k];
+            ovf |= (fabs(acc[k]) == HUGE_VAL);
+            ltemp++;
+        }
+
+        delete [] used;
+        delete [] acc;
+    } else if (any) {
+        ltemp = merge_heap(n, f, scale, Temp.indexes, Temp.coefficients, ovf,
+                           ro);
+    }
+
+    if (ro.active()) {
+        delta = ro.error(delta);
+        error = (delta > 0);
+    }
+
+    if (error) {
+        AA_STAT_SYMBOL();
+        AA_STAT_ERROR(delta);
+        Temp.indexes[ltemp] = inclast();
+        Temp.coefficients[ltemp] = delta;
+        AA_TAG_SYMBOL(Temp.indexes[ltemp], NULL);
+        ovf |= (delta == HUGE_VAL);
+        ltemp++;
+    }
+
+    Temp.length = ltemp;
+    if (ovf)
+        Temp.special = (AAF_TYPE)(Temp.special | AAF_TYPE_INFINITE);
+
+    AA_STAT_FORM(Temp.length);
+    return Temp;
+}
+
+
+// The heap merge for AAF::merge
+// returns the length of the result
+
+unsigned AAF::merge_heap(unsigned n, const AAF * const * f, const double * scale,
+                         aa_symbol * indexes, double * coefficients, bool & ovf,
+                         aa_roundoff & ro)
+{
+    const aa_symbol ** id = new const aa_symbol * [n];
+    unsigned * pos = new unsigned [n];
+    unsigned * heap = new unsigned [n];
+    AA_STAT_ALLOC(3);
+    unsigned hn = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        id[i] = f[i]->indexes;
+        pos[i] = 0;
+        if (f[i]->length)
+            heap[hn++] = i;
+    }
+
+    aaf_merge_cmp cmp;
+    cmp.id = id;
+    cmp.pos = pos;
+    std::make_heap(heap, heap+hn, cmp);
+
+    unsigned ltemp = 0;
+
+    while (hn)
+    {
+        std::pop_heap(heap, heap+hn, cmp);
+        const unsigned i = heap[hn-1];
+        const aa_symbol idx = id[i][pos[i]];
+        const double c = ro.mul(scale[i], f[i]->coefficients[pos[i]]);
+
+        if (++pos[i] < f[i]->length)
+            std::push_heap(heap, heap+hn, cmp);
+        else
+            hn--;
+
+        if (ltemp && indexes[ltemp-1] == idx) {
+            coefficients[ltemp-1] = ro.add(coefficients[ltemp-1], c);
+            ovf |= (fabs(coefficients[ltemp-1]) == HUGE_VAL);
+        } else {
+            indexes[ltemp] = idx;
+            coefficients[ltemp] = c;
+            ovf |= (fabs(c) == HUGE_VAL);
+            ltemp++;
+        }
+    }
+
+    delete [] heap;
+    delete [] pos;
+    delete [] id;
+
+    return ltemp;
+}
+
+
+// Sum of the n AAFs P[0] ... P[n-1]
+// Same as P[0] + ... + P[n-1] but with a single merge
+
+AAF aaf_sum(const AAF * P, unsigned n) {
+    AA_STAT_OP(AA_OP_SUM);
+    if (n == 0)
+        return AAF(0.);
+
+    const AAF ** f = new const AAF * [n];
+    double * scale = new double [n];
+    AA_STAT_ALLOC(2);
+
+    aa_roundoff ro;  // round-off of v0
+
+    double v0 = 0;
+    AAF_TYPE type = P[0].special;
+
+    for (unsigned i = 0; i < n; i++) {
+        f[i] = &P[i];
+        scale[i] = 1;
+        v0 = ro.add(v0, P[i].cvalue);
+        type = binary_special(type, P[i].special);
+    }
+
+    AAF Temp = AAF::merge(n, f, scale, v0, type, false, ro.active() ? ro.error() : 0);
+
+    delete [] scale;
+    delete [] f;
+
+    return Temp;
 }
 
 
@@ -231,18 +570,26 @@ AAF::AAF(const AAF & P, double alpha, double dzeta, double delta,
          AAF_TYPE type)
     : cvalue(alpha*(P.cvalue)+dzeta),
       coefficients(NULL), indexes(NULL),
-      length((P.length)+1)
+      length((P.length)+1), radius_cache(-1), owned(true)
 {
+    aa_roundoff ro;
+
+    if (ro.active())
+        cvalue = ro.add(ro.mul(alpha, P.cvalue), dzeta);
+
     special = type;
     coefficients = new double [length];
-    indexes = new unsigned [length];
+    indexes = new aa_symbol [length];
+    AA_STAT_ALLOC(2);
 
     // zi = alpha*xi
 
     for (unsigned i=0; i < P.length;i++)
     {
         indexes[i]=P.indexes[i];
-        coefficients[i]=alpha*(P.coefficients[i]);
+        coefficients[i] = ro.mul(alpha, P.coefficients[i]);
+        if (fabs(coefficients[i]) == HUGE_VAL) // overflow
+            special = (AAF_TYPE)(special | AAF_TYPE_INFINITE);
     }
 
 
@@ -250,9 +597,18 @@ AAF::AAF(const AAF & P, double alpha, double dzeta, double delta,
     // in a new noise symbol
 
     // zk = delta
+    // (+ the round-off errors, see aa_roundoff)
+
+    delta = ro.error(delta);
 
     indexes[P.length] = inclast();   // the error indx
     coefficients[P.length] = delta;
+    AA_STAT_SYMBOL();
+    AA_STAT_ERROR(delta);
+    AA_STAT_FORM(length);
+    AA_TAG_SYMBOL(indexes[P.length], NULL);
+    if (fabs(delta) == HUGE_VAL)
+        special = (AAF_TYPE)(special | AAF_TYPE_INFINITE);
 }
 
 /*
@@ -23,32 +23,118 @@
 
 
 #include "aa.h"
+#include "aa_table.h"
+#include "aa_util.h"
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <vector>
 
 
-unsigned AAF::last = 0; // at beginnnig
+aa_symbol AAF::last = 0; // at beginnnig
+__thread aa_symbol AAF::block_next = 0;
+__thread aa_symbol AAF::block_end = 0;
+__thread bool AAF::block_out = false;
+bool AAF::fast = false;
+
+
+// Take the n symbols after the highest one in use, returns the
+// first one
+
+aa_symbol AAF::reserve_block(aa_symbol n) {
+    return __sync_fetch_and_add(&last, n) + 1;
+}
+
+
+// The next n symbols created by this thread are first, first+1, ...
+// (reserved with reserve_block), the ones after come from the
+// highest one in use again and block_overflow() is then true
+// use_block(0, 0) ends the block
+
+void AAF::use_block(aa_symbol first, aa_symbol n) {
+    block_next = first;
+    block_end = first + n;
+    block_out = false;
+}
+
+bool AAF::block_overflow() {
+    return block_out;
+}
+
+
+// Turn on or off the fast mode
+// For narrow intervals exp, log and sin then use tables
+// instead of libm to bound the function (see aa_table.cpp)
+
+void AAF::set_fast_mode(bool on) {
+    if (on)
+        aa_table_init();
+    fast = on;
+}
+
+
+// Renumber the noise symbols of the live AAFs *P[0] ... *P[n-1]
+// to 1, 2, ... in the same order, so that the AAFs keep their
+// correlations and their indexes stay sorted
+// The highest symbol in use is set to the last one and returned
+// All the AAFs still in use must be in P (the others are no more
+// meaningful), the views of external arrays (AAFView) can't be
+// renumbered and the provenance tags follow their symbols
+
+aa_symbol aaf_compact(AAF * const * P, unsigned n) {
+    std::vector<AAF *> forms(P, P + n);
+    std::sort(forms.begin(), forms.end());
+    forms.erase(std::unique(forms.begin(), forms.end()), forms.end());
+
+    // The symbols in use, sorted
+
+    std::vector<aa_symbol> used;
+    for (unsigned i = 0; i < forms.size(); i++)
+        used.insert(used.end(), forms[i]->indexes, forms[i]->indexes + forms[i]->length);
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+
+    // Symbol used[k] becomes k+1 : the indexes of a form are sorted,
+    // so each one is found by an exponential search from the place of
+    // the one before (see aa_gallop)
+
+    for (unsigned i = 0; i < forms.size(); i++) {
+        AAF & f = *forms[i];
+        unsigned k = 0;
+        for (unsigned j = 0; j < f.length; j++) {
+            k = aa_gallop(&used[0], k, used.size(), f.indexes[j]);
+            f.indexes[j] = k + 1;
+        }
+    }
+
+    aa_provenance_renumber(used.empty() ? NULL : &used[0], used.size());
+
+    AAF::last = used.size();
+    return AAF::last;
+}
 
 
 // Create an AAF from an array of doubles
 // ! For debug purposes
 
-AAF:: AAF(double v0, const double * t1, const unsigned * t2, unsigned T)
-    : special(AAF_TYPE_AFFINE)
+AAF:: AAF(double v0, const double * t1, const aa_symbol * t2, unsigned T)
+    : special(AAF_TYPE_AFFINE), radius_cache(-1), owned(true)
 {
 
     length=T;
     cvalue=v0;
     coefficients = new double [length];
-    indexes = new unsigned [length];
+    indexes = new aa_symbol [length];
 
     for (unsigned i = 0; i < length; i++)
     {
         coefficients[i]=t1[i];
         indexes[i]=t2[i];
+        if (fabs(coefficients[i]) == HUGE_VAL)
+            special = (AAF_TYPE)(special | AAF_TYPE_INFINITE);
     }
 
-    if (indexes[length-1] > last) set_default(indexes[length-1]);
+    if (length) reserve(indexes[length-1]);
 
 }
 
@@ -56,11 +142,12 @@ AAF:: AAF(double v0, const double * t1, const unsigned * t2, unsigned T)
 // Copy constructor
 
 AAF:: AAF(const AAF &P)
-    : special(P.special)
+    : special(P.special), radius_cache(P.radius_cache), owned(true)
 {
     unsigned plength = P.get_length();
     coefficients = new double [plength];
-    indexes = new unsigned [plength];
+    indexes = new aa_symbol [plength];
+    AA_STAT_ALLOC(2);
 
     cvalue = P.cvalue;
     length = plength;
@@ -76,10 +163,15 @@ AAF:: AAF(const AAF &P)
 
 // Create an AAF from an interval
 
-AAF:: AAF(interval iv) {
-    unsigned en = inclast();
+AAF:: AAF(interval iv)
+    : owned(true)
+{
+    aa_symbol en = inclast();
     coefficients = new double [1];
-    indexes = new unsigned [1];
+    indexes = new aa_symbol [1];
+    AA_STAT_ALLOC(2);
+    AA_STAT_SYMBOL();
+    AA_TAG_SYMBOL(en, "input");
 
     if(iv.width() == HUGE_VAL) {
         cvalue = 0;
@@ -87,13 +179,21 @@ AAF:: AAF(interval iv) {
         coefficients[0] = HUGE_VAL;
         indexes[0] = en;
         special = AAF_TYPE_INFINITE;
+        radius_cache = HUGE_VAL;
     } else {
         cvalue=(iv.right()+iv.left())/2;
         length = 1;
 
         coefficients[0]=(iv.right()-iv.left())/2;
         indexes[0]=en;
+
+        // the interval must stay inside when the round-off counts
+
+        aa_roundoff ro;
+        if (ro.active())
+            coefficients[0] = ro.error(std::max(iv.right()-cvalue, cvalue-iv.left()));
         special = AAF_TYPE_AFFINE;
+        radius_cache = fabs(coefficients[0]);
     }
 }
 
@@ -102,11 +202,33 @@ AAF:: AAF(interval iv) {
 
 AAF::~AAF()
 {
-    if (length)
+    if (owned)
+    {
+        delete [] coefficients;
+        delete [] indexes;
+    }
+}
+
+
+// Make the AAF use external arrays (see AAFView)
+// They are neither copied nor freed
+
+void AAF::alias(double v0, const double * t1, const aa_symbol * t2, unsigned T,
+                AAF_TYPE t)
+{
+    if (owned)
     {
         delete [] coefficients;
         delete [] indexes;
     }
+
+    special = t;
+    cvalue = v0;
+    length = T;
+    coefficients = const_cast<double *>(t1);
+    indexes = const_cast<aa_symbol *>(t2);
+    radius_cache = -1;
+    owned = false;
 }
 
 
@@ -119,21 +241,24 @@ AAF & AAF::operator = (const AAF & P)
 
     if (&P!=this)
     {
-        if (length != plength)
+        if ((length != plength) || !owned)
         {
 
-            if (length)
+            if (owned)
             {
                 delete [] coefficients;
                 delete [] indexes;
             }
 
             coefficients = new double [plength];
-            indexes = new unsigned [plength];
+            indexes = new aa_symbol [plength];
+            AA_STAT_ALLOC(2);
+            owned = true;
         }
 
         cvalue = P.cvalue;
         length=plength;
+        radius_cache = P.radius_cache;
         for (unsigned i = 0; i<plength; i++)
         {
             coefficients[i]=P.coefficients[i];
@@ -190,7 +315,7 @@ void AAF::aafprint() const
     printf("v0 = %f\n", cvalue);
 
     for (unsigned i=0; i < length ; i++)
-        printf("e%d = %f\n", indexes[i], coefficients[i]);
+        printf("e%lu = %f\n", (unsigned long)indexes[i], coefficients[i]);
 }
 
 
@@ -214,15 +339,35 @@ interval AAF::convert() const
     // upper bound == central value of the AAF + the total deviation
     if(is_indeterminate())
         return interval(-HUGE_VAL, HUGE_VAL);
-    return interval(cvalue-rad(), cvalue+rad());
+
+    // -(r-cvalue) is cvalue-r, but rounded down
+    // in an aa_rounding_scope
+
+#ifdef AA_RIGOROUS
+    if (!aa_rounding_scope::active()) {
+        const double r = rad()*(1 + length*DBL_EPSILON);
+        return interval(aa_round_down(cvalue-r), aa_round_up(cvalue+r));
+    }
+#endif
+
+    const double r = rad();
+    return interval(-(r-cvalue), cvalue+r);
 }
 
 
 // Get the total deviation of an AAF
 // i.e. the sum of all noise symbols (their abs value)
+// It is only computed once, as the coefficients of an AAF
+// don't change once it has been built
+// In an aa_rounding_scope the sum is rounded up, so it is computed
+// again (the cache may hold a sum rounded to nearest) and not cached
 
 double AAF::rad() const
 {
+    const bool up = aa_rounding_scope::active();
+    if (radius_cache >= 0 && !up)
+        return radius_cache;
+
     double sum=0;
 
     for (unsigned i=0; i< length; i++) {
@@ -232,6 +377,8 @@ double AAF::rad() const
             sum+=-coefficients[i];
     }
 
+    if (!up)
+        radius_cache = sum;
 
     return sum;
 
@@ -242,7 +389,7 @@ AAF half_plane(const AAF & P) {
     const double b = P.convert().right();
 
     AAF_TYPE type;
-    if(P.special == AAF_TYPE_NAN)
+    if((P.special & (AAF_TYPE_NAN | AAF_TYPE_AFFINE)) == AAF_TYPE_NAN)
         return P;
 
     if(a > 0)
@@ -261,22 +408,25 @@ AAF half_plane(const AAF & P) {
         result.special = (AAF_TYPE)(AAF_TYPE_AFFINE | AAF_TYPE_NAN);
         unsigned plength = P.get_length();
         result.coefficients = new double [plength];
-        result.indexes = new unsigned [plength];
+        result.indexes = new aa_symbol [plength];
 
         result.cvalue = b/2;;
         result.length = plength;
+        result.radius_cache = -1;
 
         double rescale = (b - a)/b;
         for (unsigned i = 0; i<plength; i++)
         {
             result.coefficients[i] = (P.coefficients[i]*b);
             result.indexes[i] = P.indexes[i];
+            if (fabs(result.coefficients[i]) == HUGE_VAL)
+                result.special = (AAF_TYPE)(result.special | AAF_TYPE_INFINITE);
         }
         return result;
     }
 }
 
-double AAF::index_coeff(unsigned index) const {
+double AAF::index_coeff(aa_symbol index) const {
     for(int i = 0; i < length; i++)
         if(indexes[i] == index)
             return coefficients[i];
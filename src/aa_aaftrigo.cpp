@@ -25,10 +25,12 @@
 
 #include "aa.h"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
+#include "aa_table.h"
 #include "aa_util.h"
 
-#define PI (4*atan(1.0))
+#define PI M_PI
 #define NPTS 8 // number of points for the linear
                // regression approximation
 
@@ -41,6 +43,7 @@
 
 AAF sin(const AAF & P)
 {
+    AA_STAT_OP(AA_OP_SIN);
     if(P.is_infinite())
         return AAF(interval(-1,1));
     interval i = P.convert();
@@ -56,7 +59,23 @@ AAF sin(const AAF & P)
 
     double alpha, dzeta, delta;
 
-    if (w >= 2*PI ) {
+    interval s, c;
+    const double m = (a + b)/2;
+
+    if (AAF::fast_mode() && (w <= AA_NARROW_WIDTH) && aa_sincos_bound(m, s, c)) {
+// narrow interval : Taylor at the midpoint m with the tables
+        // |sin(m+t) - sin(m) - cos(m)*t| <= |sin(m)|*h^2/2 + |cos(m)|*h^3/6
+        const double h = std::max(b - m, m - a);
+        const double smax = std::max(fabs(s.left()), fabs(s.right()));
+        const double cmax = std::max(fabs(c.left()), fabs(c.right()));
+
+        alpha = (c.left() + c.right())/2;
+        dzeta = (s.left() + s.right())/2 - alpha*m;
+
+        // the uncertainty on sin(m) and cos(m) goes in the error
+        delta = h*h*(smax/2 + cmax*h/6) + (s.width() + c.width()*h)/2
+            + DBL_EPSILON*fabs(alpha*m);
+    } else if (w >= 2*PI ) {
 // the trivial case, the interval is larger than 2*PI
         // y' = 0 , delta = 1 cause -1 <= sin(x) <= +1
         return AAF(interval(-1,1));
@@ -133,6 +152,7 @@ AAF sin(const AAF & P)
 // we use the identity cos(x)=sin(x+PI/2)
 
 AAF cos(const AAF & P) {
+    AA_STAT_OP(AA_OP_COS);
     return sin(P+PI/2);
 }
 
@@ -144,6 +164,7 @@ AAF cos(const AAF & P) {
 
 AAF tan(const AAF & P)
 {
+    AA_STAT_OP(AA_OP_TAN);
     return sin(P)/cos(P);
 }
 
@@ -154,6 +175,7 @@ AAF tan(const AAF & P)
 // we can have infinite value with small intervals
 
 AAF cotan(const AAF & P){
+    AA_STAT_OP(AA_OP_COTAN);
     return cos(P)/sin(P);
 }
 
@@ -161,30 +183,36 @@ AAF cotan(const AAF & P){
 // Hyperbolics
 
 AAF cosh(const AAF & P) {
+    AA_STAT_OP(AA_OP_COSH);
     return (exp(P) + exp(-P))/2;
 }
 
 AAF sinh(const AAF & P) {
+    AA_STAT_OP(AA_OP_SINH);
     return (exp(P) - exp(-P))/2;
 }
 
 AAF tanh(const AAF & P) {
+    AA_STAT_OP(AA_OP_TANH);
     AAF ep = exp(P);
     AAF pe = exp(-P);
     return (ep-pe)/(ep+pe);
 }
 
 AAF acosh(const AAF & P) {
+    AA_STAT_OP(AA_OP_ACOSH);
     return log(P + sqrt(sqr(P) - 1));
 }
 
 AAF asinh(const AAF & P) {
+    AA_STAT_OP(AA_OP_ASINH);
     if(P.get_center() < 0)
         return -asinh(-P);
     return(log(P + sqrt(sqr(P) + 1)));
 }
 
 AAF atanh(const AAF & P) {
+    AA_STAT_OP(AA_OP_ATANH);
 
 }
 
@@ -0,0 +1,437 @@
+/*
+ * aa_binary.cpp -- Binary format of the AAFs
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_binary.h"
+#include "aa_rounding.h"
+#include "aa_util.h"
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+
+static const unsigned char magic[4] = { 'A', 'A', 'F', 'B' };
+
+#define AA_VARINT_MAX 10  // bytes of the longest varint
+
+
+// Varints : 7 bits per byte, low bits first,
+// the high bit is set on all bytes but the last one
+
+static size_t varint_size(size_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static size_t put_varint(unsigned char * p, size_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char)v;
+    return n;
+}
+
+// Returns the bytes read, 0 if the varint is cut or too long
+
+static size_t get_varint(const unsigned char * p, const unsigned char * end, size_t & v) {
+    v = 0;
+    for (size_t n = 0; (p + n < end) && (n < AA_VARINT_MAX); n++) {
+        const size_t shift = 7*n;
+        if (shift >= sizeof(size_t)*CHAR_BIT)
+            return 0;
+        v |= (size_t)(p[n] & 0x7f) << shift;
+        if (!(p[n] & 0x80))
+            return n + 1;
+    }
+    return 0;
+}
+
+
+// Little endian IEEE numbers
+
+static void put_double(unsigned char * p, double x) {
+    uint64_t u;
+    memcpy(&u, &x, 8);
+    for (unsigned i = 0; i < 8; i++)
+        p[i] = (unsigned char)(u >> (8*i));
+}
+
+static double get_double(const unsigned char * p) {
+    uint64_t u = 0;
+    for (unsigned i = 0; i < 8; i++)
+        u |= (uint64_t)p[i] << (8*i);
+    double x;
+    memcpy(&x, &u, 8);
+    return x;
+}
+
+static void put_float(unsigned char * p, float x) {
+    uint32_t u;
+    memcpy(&u, &x, 4);
+    for (unsigned i = 0; i < 4; i++)
+        p[i] = (unsigned char)(u >> (8*i));
+}
+
+static float get_float(const unsigned char * p) {
+    uint32_t u = 0;
+    for (unsigned i = 0; i < 4; i++)
+        u |= (uint32_t)p[i] << (8*i);
+    float x;
+    memcpy(&x, &u, 4);
+    return x;
+}
+
+
+// Write the header in buf (AA_BINARY_HEADER_SIZE bytes)
+
+size_t aaf_pack_header(unsigned char * buf) {
+    memcpy(buf, magic, 4);
+    buf[4] = AA_BINARY_VERSION;
+    return AA_BINARY_HEADER_SIZE;
+}
+
+
+// Version of the header in buf
+// 0 if it isn't one or if the version is unknown
+
+unsigned aaf_header_version(const unsigned char * buf, size_t n) {
+    if ((n < AA_BINARY_HEADER_SIZE) || memcmp(buf, magic, 4))
+        return 0;
+    if ((buf[4] == 0) || (buf[4] > AA_BINARY_VERSION))
+        return 0;
+    return buf[4];
+}
+
+
+// Pack P in buf, which must be large enough
+// Returns the size of the record
+// If buf is NULL nothing is written, so this gives the size needed
+// The coefficients are only truncated if they all fit in a float
+
+size_t aaf_pack(const AAF & P, unsigned char * buf, bool truncate) {
+    const unsigned length = P.get_length();
+
+    if (truncate) {
+        if (P.is_indeterminate())
+            truncate = false;
+        for (unsigned i = 0; truncate && (i < length); i++)
+            truncate = (fabs(P.get_coeff(i)) <= FLT_MAX);
+    }
+
+    size_t isize = 0;
+    aa_symbol prev = 0;
+    for (unsigned i = 0; i < length; i++) {
+        isize += varint_size(P.get_index(i) - prev);
+        prev = P.get_index(i);
+    }
+
+    const size_t w = truncate ? 4 : 8;
+    const size_t size = 2 + varint_size(length) + varint_size(isize)
+        + 8 + (truncate ? 8 : 0) + length*w + isize;
+
+    if (!buf)
+        return size;
+
+    unsigned char * p = buf;
+    *p++ = (unsigned char)P.get_special();
+    *p++ = truncate ? AA_BINARY_FLOAT : 0;
+    p += put_varint(p, length);
+    p += put_varint(p, isize);
+    put_double(p, P.get_center());
+    p += 8;
+
+    if (truncate) {
+        // The truncation errors are exact, only their sum is rounded
+
+        unsigned char * perr = p;
+        p += 8;
+
+        double err = 0;
+        for (unsigned i = 0; i < length; i++, p += 4) {
+            const float c = (float)P.get_coeff(i);
+            err += fabs(P.get_coeff(i) - c);
+            put_float(p, c);
+        }
+
+        if (err > 0)
+            err = aa_round_up((err + length*AA_MIN_DENORM)*(1 + length*DBL_EPSILON));
+        put_double(perr, err);
+    } else {
+        for (unsigned i = 0; i < length; i++, p += 8)
+            put_double(p, P.get_coeff(i));
+    }
+
+    prev = 0;
+    for (unsigned i = 0; i < length; i++) {
+        p += put_varint(p, P.get_index(i) - prev);
+        prev = P.get_index(i);
+    }
+
+    return size;
+}
+
+
+// Write the header to a stream
+
+bool aaf_write_header(std::ostream & s) {
+    unsigned char buf[AA_BINARY_HEADER_SIZE];
+    aaf_pack_header(buf);
+    s.write((const char *)buf, AA_BINARY_HEADER_SIZE);
+    return s.good();
+}
+
+
+// Read the header of a stream
+// Returns its version, 0 if it isn't a libaffa stream
+
+unsigned aaf_read_header(std::istream & s) {
+    unsigned char buf[AA_BINARY_HEADER_SIZE];
+    if (!s.read((char *)buf, AA_BINARY_HEADER_SIZE))
+        return 0;
+    return aaf_header_version(buf, AA_BINARY_HEADER_SIZE);
+}
+
+
+// Write an AAF to a stream
+
+bool aaf_write(std::ostream & s, const AAF & P, bool truncate) {
+    std::vector<unsigned char> buf(aaf_pack(P, NULL, truncate));
+    aaf_pack(P, &buf[0], truncate);
+    s.write((const char *)&buf[0], buf.size());
+    return s.good();
+}
+
+
+// Write n AAFs to a stream
+
+bool aaf_write(std::ostream & s, const AAF * P, unsigned n, bool truncate) {
+    std::vector<unsigned char> buf;
+
+    for (unsigned i = 0; i < n; i++) {
+        buf.resize(aaf_pack(P[i], NULL, truncate));
+        aaf_pack(P[i], &buf[0], truncate);
+        if (!s.write((const char *)&buf[0], buf.size()))
+            return false;
+    }
+
+    return true;
+}
+
+
+// Read an AAF from a stream
+// Returns false (and P is unchanged) at the end of the stream
+// or if the record is corrupted
+
+bool aaf_read(std::istream & s, AAF & P) {
+    std::vector<unsigned char> buf(2);
+    if (!s.read((char *)&buf[0], 2))
+        return false;
+
+    // the two varints
+
+    size_t v[2];
+    for (unsigned k = 0; k < 2; k++) {
+        const size_t start = buf.size();
+        int c;
+        do {
+            if ((c = s.get()) == EOF || buf.size() - start >= AA_VARINT_MAX)
+                return false;
+            buf.push_back((unsigned char)c);
+        } while (c & 0x80);
+        get_varint(&buf[start], &buf[0] + buf.size(), v[k]);
+    }
+
+    // don't trust the sizes before they are checked by aaf_packed
+
+    const size_t w = (buf[1] & AA_BINARY_FLOAT) ? 4 : 8;
+    if ((v[0] > UINT_MAX/16) || (v[1] > AA_VARINT_MAX*v[0]))
+        return false;
+
+    const size_t head = buf.size();
+    buf.resize(head + 8 + ((w == 4) ? 8 : 0) + v[0]*w + v[1]);
+    if (!s.read((char *)&buf[head], buf.size() - head))
+        return false;
+
+    aaf_packed r(&buf[0], buf.size());
+    if (!r.valid())
+        return false;
+
+    P = r.unpack();
+    return true;
+}
+
+
+// aaf_packed
+
+// Parse the beginning of the record in buf (of n bytes)
+// The record is invalid if it's cut
+
+aaf_packed::aaf_packed(const unsigned char * buf, size_t n)
+    : data(buf), size(0), length(0), flags(0), coeffs(0), idx(0)
+{
+    const unsigned char * end = buf + n;
+
+    if (n < 2)
+        return;
+
+    flags = buf[1];
+    if (flags & ~AA_BINARY_FLOAT)
+        return;
+
+    size_t l, isize, r;
+    const unsigned char * p = buf + 2;
+
+    if (!(r = get_varint(p, end, l)) || (l > UINT_MAX))
+        return;
+    p += r;
+    if (!(r = get_varint(p, end, isize)))
+        return;
+    p += r;
+
+    const size_t w = (flags & AA_BINARY_FLOAT) ? 4 : 8;
+    const size_t avail = end - p;
+    const size_t fixed = 8 + ((w == 4) ? 8 : 0);
+
+    if ((avail < fixed) || ((avail - fixed)/w < l)
+        || (avail - fixed - l*w < isize))
+        return;
+
+    length = (unsigned)l;
+    coeffs = (p - buf) + fixed;
+    idx = coeffs + l*w;
+    size = idx + isize;
+}
+
+
+double aaf_packed::get_center() const {
+    return get_double(data + coeffs - ((flags & AA_BINARY_FLOAT) ? 16 : 8));
+}
+
+
+// i-th coefficient, as stored
+
+double aaf_packed::get_coeff(unsigned i) const {
+    if (i >= length)
+        return 0;
+    if (flags & AA_BINARY_FLOAT)
+        return get_float(data + coeffs + 4*i);
+    return get_double(data + coeffs + 8*i);
+}
+
+
+// The truncation error, 0 if the coefficients aren't truncated
+
+double aaf_packed::get_error() const {
+    if (flags & AA_BINARY_FLOAT)
+        return get_double(data + coeffs - 8);
+    return 0;
+}
+
+
+// Total deviation, as AAF::rad() (with the truncation error)
+
+double aaf_packed::rad() const {
+    double sum = get_error();
+    for (unsigned i = 0; i < length; i++)
+        sum += fabs(get_coeff(i));
+    return sum;
+}
+
+
+// Enclosure of the AAF, as AAF::convert()
+
+interval aaf_packed::convert() const {
+    if (get_special() & (AAF_TYPE_INFINITE | AAF_TYPE_NAN))
+        return interval(-HUGE_VAL, HUGE_VAL);
+
+    const double r = rad();
+    return interval(get_center() - r, get_center() + r);
+}
+
+
+// Build the AAF
+// A corrupted index list gives an AAF_TYPE_NAN
+
+AAF aaf_packed::unpack() const {
+    if (!valid())
+        return AAF(AAF_TYPE_NAN);
+
+    const double err = get_error();
+    const unsigned l = length + ((err > 0) ? 1 : 0);
+
+    AAF Temp(get_center());
+    Temp.special = get_special();
+    Temp.radius_cache = -1;
+
+    if (l == 0)
+        return Temp;
+
+    Temp.indexes = new aa_symbol [l];
+    Temp.coefficients = new double [l];
+    Temp.length = l;
+
+    const unsigned char * p = data + idx;
+    const unsigned char * end = data + size;
+    aa_symbol prev = 0;
+
+    for (unsigned i = 0; i < length; i++) {
+        size_t d;
+        const size_t r = get_varint(p, end, d);
+        if (!r || (i && !d) || (d > AA_SYMBOL_MAX - prev))
+            return AAF(AAF_TYPE_NAN);
+        p += r;
+        prev += d;
+        Temp.indexes[i] = prev;
+        Temp.coefficients[i] = get_coeff(i);
+    }
+
+    if (length)
+        AAF::reserve(Temp.indexes[length-1]);
+
+    if (err > 0) {
+        Temp.indexes[length] = AAF::inclast();
+        AA_TAG_SYMBOL(Temp.indexes[length], "unpack");
+        Temp.coefficients[length] = err;
+    }
+
+    return Temp;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
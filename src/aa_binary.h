@@ -0,0 +1,154 @@
+/*
+ * aa_binary.h -- Binary format of the AAFs
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_BINARY_H
+#define AA_BINARY_H
+
+#include "aa_aaf.h"
+#include <cstddef>
+#include <iostream>
+
+
+// A file (or buffer) is a header followed by packed AAFs
+//
+// header : "AAFB" and the version, 5 bytes
+//
+// packed AAF, all numbers are little endian :
+//   special flags                  1 byte
+//   format flags                   1 byte (AA_BINARY_*)
+//   length                         varint
+//   size of the indexes            varint (in bytes)
+//   central value                  double
+//   truncation error               double (if AA_BINARY_FLOAT)
+//   coefficients                   length doubles or floats
+//   indexes                        varints, each one minus the previous
+//
+// The coefficients have a fixed size, so a packed AAF can be used
+// in place (see aaf_packed) and only the indexes need decoding
+// When they are truncated to floats the error made goes into a new
+// noise symbol when the AAF is unpacked, so it still encloses the
+// original one
+// The indexes are the noise symbols of the writer : on unpacking, the
+// highest symbol in use is moved above them (see AAF::set_default)
+
+#define AA_BINARY_VERSION 1
+#define AA_BINARY_HEADER_SIZE 5
+
+#define AA_BINARY_FLOAT 1  // coefficients truncated to floats
+
+
+// Buffers
+
+size_t aaf_pack_header(unsigned char * buf);
+unsigned aaf_header_version(const unsigned char * buf, size_t n);
+
+size_t aaf_pack(const AAF & P, unsigned char * buf, bool truncate = false);
+
+
+// Streams
+
+bool aaf_write_header(std::ostream & s);
+unsigned aaf_read_header(std::istream & s);
+
+bool aaf_write(std::ostream & s, const AAF & P, bool truncate = false);
+bool aaf_write(std::ostream & s, const AAF * P, unsigned n, bool truncate = false);
+bool aaf_read(std::istream & s, AAF & P);
+
+
+// A packed AAF read in place (e.g. in a mmap'd file)
+// Nothing is copied until unpack()
+
+class aaf_packed
+{
+
+private:
+    const unsigned char * data;
+    size_t size;        // size of the record, 0 if invalid
+
+    unsigned length;
+    unsigned flags;
+    size_t coeffs;      // offset of the coefficients
+    size_t idx;         // offset of the indexes
+
+public:
+    aaf_packed(const unsigned char * buf, size_t n);
+
+    bool valid() const;
+    size_t bytes() const;
+    const unsigned char * next() const;
+
+    AAF_TYPE get_special() const;
+    unsigned get_length() const;
+    double get_center() const;
+    double get_coeff(unsigned i) const;
+    double get_error() const;
+    double rad() const;
+    interval convert() const;
+
+    AAF unpack() const;
+};
+
+
+// aaf_packed inline functions
+
+// Says if the record is complete and well formed
+
+inline bool aaf_packed::valid() const {
+    return size != 0;
+}
+
+
+// Size of the record
+
+inline size_t aaf_packed::bytes() const {
+    return size;
+}
+
+
+// The next record in the buffer
+
+inline const unsigned char * aaf_packed::next() const {
+    return data + size;
+}
+
+
+inline AAF_TYPE aaf_packed::get_special() const {
+    return (AAF_TYPE)data[0];
+}
+
+
+inline unsigned aaf_packed::get_length() const {
+    return length;
+}
+
+#endif  // AA_BINARY_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
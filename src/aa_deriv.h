@@ -0,0 +1,144 @@
+/*
+ * aa_deriv.h -- Derivatives of the elementary functions of AAFs
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_DERIV_H
+#define AA_DERIV_H
+
+#include "aa_aaf.h"
+
+
+// The parts of the chain rule shared by the forward (aaf_dual) and the
+// reverse (aa_tape) modes
+
+// a*b, without a new noise symbol when one of them is a constant
+// (the seeds, the derivatives of +, - and of the operations by a
+// constant)
+
+inline AAF aa_times(const AAF & a, const AAF & b) {
+    if (!b.get_length() && !b.is_indeterminate())
+        return (b.get_center() == 0) ? AAF(0.) : a*b.get_center();
+    if (!a.get_length() && !a.is_indeterminate())
+        return (a.get_center() == 0) ? AAF(0.) : b*a.get_center();
+    return a*b;
+}
+
+
+// f(u) and f'(u) of an elementary function f, enclosed in AA on the
+// range of u (f'(u) is computed from f(u) when it can)
+
+struct aa_deriv
+{
+    AAF value;  // f(u)
+    AAF slope;  // f'(u)
+
+    aa_deriv(const AAF & fu, const AAF & fp) : value(fu), slope(fp) {}
+};
+
+inline aa_deriv aa_deriv_sqr(const AAF & u) {
+    return aa_deriv(sqr(u), u*2.);
+}
+
+inline aa_deriv aa_deriv_sqrt(const AAF & u) {
+    const AAF s = sqrt(u);
+    return aa_deriv(s, inv(s)*0.5);
+}
+
+inline aa_deriv aa_deriv_inv(const AAF & u) {
+    const AAF s = inv(u);
+    return aa_deriv(s, -sqr(s));
+}
+
+inline aa_deriv aa_deriv_exp(const AAF & u) {
+    const AAF s = exp(u);
+    return aa_deriv(s, s);
+}
+
+inline aa_deriv aa_deriv_log(const AAF & u) {
+    return aa_deriv(log(u), inv(u));
+}
+
+// (n != 0)
+
+inline aa_deriv aa_deriv_pow(const AAF & u, int n) {
+    return aa_deriv(pow(u, n), pow(u, n - 1)*(double)n);
+}
+
+inline aa_deriv aa_deriv_pow(const AAF & u, double p) {
+    return aa_deriv(pow(u, p), pow(u, p - 1)*p);
+}
+
+// The derivative is -1, 1, or [-1,1] where u straddles 0
+
+inline aa_deriv aa_deriv_abs(const AAF & u) {
+    if (u.strictly_neg())
+        return aa_deriv(-u, -1.);
+    if (u.straddles_zero())
+        return aa_deriv(abs(u), AAF(interval(-1, 1)));
+    return aa_deriv(u, 1.);
+}
+
+inline aa_deriv aa_deriv_sin(const AAF & u) {
+    return aa_deriv(sin(u), cos(u));
+}
+
+inline aa_deriv aa_deriv_cos(const AAF & u) {
+    return aa_deriv(cos(u), -sin(u));
+}
+
+inline aa_deriv aa_deriv_tan(const AAF & u) {
+    const AAF s = tan(u);
+    return aa_deriv(s, sqr(s) + 1.);
+}
+
+inline aa_deriv aa_deriv_sinh(const AAF & u) {
+    return aa_deriv(sinh(u), cosh(u));
+}
+
+inline aa_deriv aa_deriv_cosh(const AAF & u) {
+    return aa_deriv(cosh(u), sinh(u));
+}
+
+inline aa_deriv aa_deriv_tanh(const AAF & u) {
+    const AAF s = tanh(u);
+    return aa_deriv(s, 1. - sqr(s));
+}
+
+inline aa_deriv aa_deriv_asinh(const AAF & u) {
+    return aa_deriv(asinh(u), inv(sqrt(sqr(u) + 1.)));
+}
+
+inline aa_deriv aa_deriv_acosh(const AAF & u) {
+    return aa_deriv(acosh(u), inv(sqrt(sqr(u) - 1.)));
+}
+
+#endif  // AA_DERIV_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,214 @@
+/*
+ * aa_dual.h -- Forward mode derivatives of AAFs
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_DUAL_H
+#define AA_DUAL_H
+
+#include "aa_aaf.h"
+#include "aa_deriv.h"
+
+
+// An AAF with its N partial derivatives, also AAFs :
+// f(x) is in value() and df/dx[i](x) in deriv(i) for every x of the
+// inputs, the derivatives of the elementary functions being enclosed
+// in AA on the range of their argument
+//
+// The inputs are seeded with their rank, the constants have no
+// derivatives :
+//
+//   aaf_dual<2> x(AAF(interval(1, 2)), 0), y(AAF(interval(0, 1)), 1);
+//   aaf_dual<2> f = x*exp(y) + 1.;
+//   f.value(), f.deriv(0), f.deriv(1)
+//
+// The value and the derivatives share the noise symbols of the inputs
+// (and of the intermediate results), so an AAF computed from them,
+// e.g. a Taylor form f(x0) + df/dx*(x - x0), keeps their correlations
+// The factor f'(u) of the chain rule is computed once for all the
+// derivatives of f(u)
+
+template <unsigned N> class aaf_dual
+{
+
+private:
+    AAF v;
+    AAF d[N];
+
+    // f(u) of value f.value, with f'(u) in f.slope
+
+    static aaf_dual chain(const aa_deriv & f, const aaf_dual & u) {
+        aaf_dual r(f.value);
+        for (unsigned i = 0; i < N; i++)
+            r.d[i] = aa_times(u.d[i], f.slope);
+        return r;
+    }
+
+public:
+
+    // A constant
+
+    aaf_dual(double c = 0) : v(c) {}
+    aaf_dual(const AAF & c) : v(c) {}
+
+    // The input number i (its derivative is 1 along i)
+
+    aaf_dual(const AAF & x, unsigned i) : v(x) {
+        if (i < N)
+            d[i] = 1;
+    }
+
+    const AAF & value() const {
+        return v;
+    }
+
+    const AAF & deriv(unsigned i) const {
+        return d[i];
+    }
+
+    const AAF * gradient() const {
+        return d;
+    }
+
+    // Arithmetic (the doubles and the AAFs are converted to constants)
+
+    friend aaf_dual operator + (const aaf_dual & a, const aaf_dual & b) {
+        aaf_dual r(a.v + b.v);
+        for (unsigned i = 0; i < N; i++)
+            r.d[i] = a.d[i] + b.d[i];
+        return r;
+    }
+
+    friend aaf_dual operator - (const aaf_dual & a, const aaf_dual & b) {
+        aaf_dual r(a.v - b.v);
+        for (unsigned i = 0; i < N; i++)
+            r.d[i] = a.d[i] - b.d[i];
+        return r;
+    }
+
+    friend aaf_dual operator - (const aaf_dual & a) {
+        aaf_dual r(-a.v);
+        for (unsigned i = 0; i < N; i++)
+            r.d[i] = -a.d[i];
+        return r;
+    }
+
+    friend aaf_dual operator * (const aaf_dual & a, const aaf_dual & b) {
+        aaf_dual r(aa_times(a.v, b.v));
+        for (unsigned i = 0; i < N; i++)
+            r.d[i] = aa_times(a.d[i], b.v) + aa_times(b.d[i], a.v);
+        return r;
+    }
+
+    // (a/b)' = (a' - (a/b)*b')/b, with 1/b computed once
+
+    friend aaf_dual operator / (const aaf_dual & a, const aaf_dual & b) {
+        const AAF ib = inv(b.v);
+        aaf_dual r(aa_times(a.v, ib));
+        for (unsigned i = 0; i < N; i++)
+            r.d[i] = aa_times(a.d[i] - aa_times(b.d[i], r.v), ib);
+        return r;
+    }
+
+    // Elementary functions (see aa_deriv.h)
+
+    friend aaf_dual sqr(const aaf_dual & u) {
+        return chain(aa_deriv_sqr(u.v), u);
+    }
+
+    friend aaf_dual sqrt(const aaf_dual & u) {
+        return chain(aa_deriv_sqrt(u.v), u);
+    }
+
+    friend aaf_dual inv(const aaf_dual & u) {
+        return chain(aa_deriv_inv(u.v), u);
+    }
+
+    friend aaf_dual exp(const aaf_dual & u) {
+        return chain(aa_deriv_exp(u.v), u);
+    }
+
+    friend aaf_dual log(const aaf_dual & u) {
+        return chain(aa_deriv_log(u.v), u);
+    }
+
+    friend aaf_dual pow(const aaf_dual & u, int n) {
+        if (n == 0)
+            return aaf_dual(1.);
+        return chain(aa_deriv_pow(u.v, n), u);
+    }
+
+    friend aaf_dual pow(const aaf_dual & u, double p) {
+        if (p == 0)
+            return aaf_dual(1.);
+        if (p == 1)
+            return u;
+        return chain(aa_deriv_pow(u.v, p), u);
+    }
+
+    friend aaf_dual abs(const aaf_dual & u) {
+        return chain(aa_deriv_abs(u.v), u);
+    }
+
+    friend aaf_dual sin(const aaf_dual & u) {
+        return chain(aa_deriv_sin(u.v), u);
+    }
+
+    friend aaf_dual cos(const aaf_dual & u) {
+        return chain(aa_deriv_cos(u.v), u);
+    }
+
+    friend aaf_dual tan(const aaf_dual & u) {
+        return chain(aa_deriv_tan(u.v), u);
+    }
+
+    friend aaf_dual sinh(const aaf_dual & u) {
+        return chain(aa_deriv_sinh(u.v), u);
+    }
+
+    friend aaf_dual cosh(const aaf_dual & u) {
+        return chain(aa_deriv_cosh(u.v), u);
+    }
+
+    friend aaf_dual tanh(const aaf_dual & u) {
+        return chain(aa_deriv_tanh(u.v), u);
+    }
+
+    friend aaf_dual asinh(const aaf_dual & u) {
+        return chain(aa_deriv_asinh(u.v), u);
+    }
+
+    friend aaf_dual acosh(const aaf_dual & u) {
+        return chain(aa_deriv_acosh(u.v), u);
+    }
+};
+
+#endif  // AA_DUAL_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
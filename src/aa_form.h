@@ -0,0 +1,343 @@
+/*
+ * aa_form.h -- Affine forms with float or long double coefficients
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_FORM_H
+#define AA_FORM_H
+
+#include "aa_aaf.h"
+#include "aa_interval.h"
+#include "aa_provenance.h"
+#include "aa_rounding.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+
+
+// Affine form whose center and coefficients are of type T
+//
+//   x = center + sum coeff_i*e_i + error*[-1,1]
+//
+// The noise symbols are the ones of the AAFs, so an AAF converted to
+// aaf_form<float> (a term takes 8 bytes instead of 12 with 32 bit
+// symbols, and a vector register holds twice as many coefficients)
+// and back keeps its correlations, and a long double one can sum
+// forms with little round-off
+// The conversions are sound : what a coefficient loses when it's
+// rounded to a narrower type goes to error, and to_aaf() puts error in
+// a new noise symbol (as aaf_read() does with truncated floats)
+// The round-off errors of the operations, always bounded here, also go
+// to error
+//
+// Only the affine operations (+, -, negation and the product by a T)
+// are provided, and only they run in T : the other ones are done on
+// to_aaf(), in double, so a long double form is no tighter than an AAF
+// there
+// T may be any type with std::numeric_limits, fabs and the operators
+// of double (e.g. a double-double type)
+//
+//   aaf_form<float> f(x);          // x an AAF
+//   f = f*2.f + aaf_form<float>(y);
+//   f.convert()                    // encloses 2*x + y
+
+template <class T> class aaf_form
+{
+
+private:
+    T center;
+    std::vector<aa_symbol> indexes;
+    std::vector<T> coefficients;
+    T error;
+    AAF_TYPE special;
+
+    // x >= the exact value when x is a result within one ulp of it,
+    // whatever the rounding mode
+
+    static T up(T x) {
+        using std::fabs;
+        return x + (fabs(x)*std::numeric_limits<T>::epsilon() +
+                    std::numeric_limits<T>::denorm_min());
+    }
+
+    // gamma_n = n*eps/(1 - n*eps) of U, rounded up : n operations in a
+    // row lose at most gamma_n of their exact result (it is infinite
+    // when n*eps >= 1/2, where it doesn't bound anything)
+
+    template <class U> static U gamma(unsigned n) {
+        const U eps = std::numeric_limits<U>::epsilon();
+        const U ne = U(n)*eps;
+        if (!(ne < U(0.5)))
+            return std::numeric_limits<U>::infinity();
+        const U g = ne/(1 - ne);
+        return g + g*eps;
+    }
+
+    // Bound of the exact sum of k terms >= 0 whose sum in T is sum
+    // The k - 1 additions lose at most gamma_{k-1} of the exact sum s,
+    // so s <= sum/(1 - gamma_{k-1}) <= sum*(1 + gamma_2k)
+
+    static T exact_sum(T sum, unsigned k) {
+        return (k > 1 && sum > 0) ? up(sum + up(sum*gamma<T>(2*k))) : sum;
+    }
+
+    // Bound of the round-off of k results whose |r| add up to sum (in T)
+
+    static T roundoff(T sum, unsigned k) {
+        const T eps = std::numeric_limits<T>::epsilon();
+        return up(up(exact_sum(sum, k)*eps) + std::numeric_limits<T>::denorm_min()*T(k));
+    }
+
+    // d, and what is lost when it's rounded to T in lost
+
+    static T narrow(double d, double & lost) {
+        using std::fabs;
+        const T t = T(d);
+        lost += fabs(d - double(t));
+        return t;
+    }
+
+    // Bounds of t in double
+
+    static double down_double(T t) {
+        double d = double(t);
+        if (T(d) > t)
+            d = nextafter(d, -HUGE_VAL);
+        return d;
+    }
+
+    static double up_double(T t) {
+        double d = double(t);
+        if (T(d) < t)
+            d = nextafter(d, HUGE_VAL);
+        return d;
+    }
+
+    void check() {
+        using std::fabs;
+        for (unsigned i = 0; i < coefficients.size(); i++)
+            if (!(fabs(coefficients[i]) <= std::numeric_limits<T>::max()))
+                special = (AAF_TYPE)(special | AAF_TYPE_INFINITE);
+        if (!(fabs(center) <= std::numeric_limits<T>::max()) ||
+            !(error <= std::numeric_limits<T>::max()))
+            special = (AAF_TYPE)(special | AAF_TYPE_INFINITE);
+    }
+
+public:
+
+    aaf_form(T c = 0) : center(c), error(0), special(AAF_TYPE_AFFINE) {}
+    explicit aaf_form(const AAF & P);
+
+    AAF to_aaf() const;
+
+    unsigned get_length() const {
+        return indexes.size();
+    }
+    T get_center() const {
+        return center;
+    }
+    T get_coeff(unsigned i) const {
+        return (i < coefficients.size()) ? coefficients[i] : T(0);
+    }
+    aa_symbol get_index(unsigned i) const {
+        return (i < indexes.size()) ? indexes[i] : 0;
+    }
+    T get_error() const {
+        return error;
+    }
+    AAF_TYPE get_special() const {
+        return special;
+    }
+    bool is_indeterminate() const {
+        return special != AAF_TYPE_AFFINE;
+    }
+
+    T rad() const;
+    interval convert() const;
+
+    aaf_form operator + (const aaf_form & Q) const;
+    aaf_form operator - (const aaf_form & Q) const;
+    aaf_form operator - () const;
+    aaf_form operator * (T c) const;
+};
+
+typedef aaf_form<float> aaf_float;
+typedef aaf_form<long double> aaf_long;
+
+
+// aaf_form template functions
+
+template <class T> aaf_form<T>::aaf_form(const AAF & P)
+    : indexes(P.get_length()), coefficients(P.get_length()), special(P.get_special())
+{
+    double lost = 0;
+    center = narrow(P.get_center(), lost);
+    for (unsigned i = 0; i < indexes.size(); i++) {
+        indexes[i] = P.get_index(i);
+        coefficients[i] = narrow(P.get_coeff(i), lost);
+    }
+
+    // each loss is exact in double, their sum is rounded
+
+    const unsigned n = indexes.size() + 1;
+    error = (lost > 0) ? T(aa_round_up(lost + aa_round_up(lost*gamma<double>(2*n)))) : T(0);
+    if (error > 0)
+        error = up(error);
+    check();
+}
+
+
+// An AAF enclosing the form, error is put in a new noise symbol
+// (with what the center and the coefficients lose in double)
+
+template <class T> AAF aaf_form<T>::to_aaf() const {
+    using std::fabs;
+    if (is_indeterminate())
+        return AAF(special);
+
+    const unsigned l = indexes.size();
+    std::vector<double> c(l + 1);
+    std::vector<aa_symbol> id(l + 1);
+
+    T lost = 0;
+    for (unsigned i = 0; i < l; i++) {
+        c[i] = double(coefficients[i]);
+        lost += fabs(coefficients[i] - T(c[i]));
+        id[i] = indexes[i];
+    }
+    const double v0 = double(center);
+    lost += fabs(center - T(v0));
+
+    double err = 0;
+    if (lost > 0 || error > 0)
+        err = up_double(up(error + exact_sum(lost, l + 1)));
+
+    if (err > 0) {
+        id[l] = AAF::inclast();
+        if (aa_provenance_enabled())
+            aa_provenance_tag(id[l], "to_aaf");
+        c[l] = err;
+        return AAF(v0, &c[0], &id[0], l + 1);
+    }
+    return AAF(v0, &c[0], &id[0], l);
+}
+
+
+// Total deviation, rounded up
+
+template <class T> T aaf_form<T>::rad() const {
+    using std::fabs;
+    T sum = 0;
+    for (unsigned i = 0; i < coefficients.size(); i++)
+        sum += fabs(coefficients[i]);
+    return up(exact_sum(sum, coefficients.size()) + error);
+}
+
+
+template <class T> interval aaf_form<T>::convert() const {
+    using std::fabs;
+    if (is_indeterminate())
+        return interval(-HUGE_VAL, HUGE_VAL);
+
+    const T r = rad();
+    T lo = center - r;
+    T hi = center + r;
+    lo = lo - roundoff(fabs(lo), 1);
+    hi = hi + roundoff(fabs(hi), 1);
+    return interval(down_double(lo), up_double(hi));
+}
+
+
+// The lists of symbols are merged, each sum is rounded once
+
+template <class T> aaf_form<T> aaf_form<T>::operator + (const aaf_form & Q) const {
+    using std::fabs;
+    aaf_form R(center + Q.center);
+    R.special = (AAF_TYPE)(special | Q.special);
+
+    const unsigned l1 = indexes.size(), l2 = Q.indexes.size();
+    R.indexes.reserve(l1 + l2);
+    R.coefficients.reserve(l1 + l2);
+
+    T sum = fabs(R.center);
+    unsigned i = 0, j = 0;
+    while (i < l1 || j < l2) {
+        if (j == l2 || (i < l1 && indexes[i] < Q.indexes[j])) {
+            R.indexes.push_back(indexes[i]);
+            R.coefficients.push_back(coefficients[i++]);
+        } else if (i == l1 || Q.indexes[j] < indexes[i]) {
+            R.indexes.push_back(Q.indexes[j]);
+            R.coefficients.push_back(Q.coefficients[j++]);
+        } else {
+            const T c = coefficients[i++] + Q.coefficients[j++];
+            R.indexes.push_back(Q.indexes[j-1]);
+            R.coefficients.push_back(c);
+            sum += fabs(c);
+        }
+    }
+
+    R.error = up(up(error + Q.error) + roundoff(sum, l1 + 1));
+    R.check();
+    return R;
+}
+
+
+template <class T> aaf_form<T> aaf_form<T>::operator - () const {
+    aaf_form R(*this);
+    R.center = -center;
+    for (unsigned i = 0; i < R.coefficients.size(); i++)
+        R.coefficients[i] = -R.coefficients[i];
+    return R;
+}
+
+
+template <class T> aaf_form<T> aaf_form<T>::operator - (const aaf_form & Q) const {
+    return *this + (-Q);
+}
+
+
+template <class T> aaf_form<T> aaf_form<T>::operator * (T c) const {
+    using std::fabs;
+    aaf_form R(*this);
+    R.center = center*c;
+
+    T sum = fabs(R.center);
+    for (unsigned i = 0; i < R.coefficients.size(); i++) {
+        R.coefficients[i] = coefficients[i]*c;
+        sum += fabs(R.coefficients[i]);
+    }
+
+    R.error = up(up(error*fabs(c)) + roundoff(sum, R.coefficients.size() + 1));
+    R.check();
+    return R;
+}
+
+#endif  // AA_FORM_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,220 @@
+/*
+ * aa_hybrid.cpp -- Hybrid interval / affine arithmetic class
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_hybrid.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+unsigned hybrid::max_length = 32;
+double hybrid::max_ratio = 4;
+
+
+// Set when the affine form is dropped :
+// when it has more than length noise symbols
+// or when its enclosure is ratio times wider than the interval one
+
+void hybrid::set_drop(unsigned length, double ratio) {
+    max_length = length;
+    max_ratio = ratio;
+}
+
+
+// Create a constant
+
+hybrid::hybrid(double v)
+    : iv(v), form(v), affine(true)
+{
+}
+
+
+// Create a hybrid from an interval
+// i.e. with a new noise symbol
+
+hybrid::hybrid(interval i)
+    : iv(i), form(i), affine(true)
+{
+}
+
+
+// Create a hybrid from an affine form
+
+hybrid::hybrid(const AAF & f)
+    : iv(f.convert()), form(f), affine(true)
+{
+}
+
+
+// Result of an operation done in both models
+// The interval i is intersected with the enclosure of f
+// and f is dropped if it costs more than it saves
+
+hybrid::hybrid(const AAF & f, const interval & i)
+    : iv(i), form(f), affine(true)
+{
+    const interval a = f.convert();
+    const double lo = std::max(i.left(), a.left());
+    const double hi = std::min(i.right(), a.right());
+
+    // An empty intersection can only come from rounding
+    // (the AAF operations are only rigorous in an aa_rounding_scope)
+    // so we trust the interval
+
+    if (lo <= hi)
+        iv = interval(lo, hi);
+
+    if ((f.get_length() > max_length) || f.is_nan()
+        || (a.width() > max_ratio*i.width())) {
+        form = AAF(0.);
+        affine = false;
+    }
+}
+
+
+// A hybrid without affine form
+
+hybrid hybrid::interval_only(const interval & i) {
+    hybrid Temp(0.);
+    Temp.iv = i;
+    Temp.affine = false;
+    return Temp;
+}
+
+
+// Binary operations
+// The result keeps an affine form only if both operands have one
+
+hybrid operator + (const hybrid & P, const hybrid & Q) {
+    if (P.affine && Q.affine)
+        return hybrid(P.form + Q.form, P.iv + Q.iv);
+    return hybrid::interval_only(P.iv + Q.iv);
+}
+
+hybrid operator - (const hybrid & P, const hybrid & Q) {
+    if (P.affine && Q.affine)
+        return hybrid(P.form - Q.form, P.iv - Q.iv);
+    return hybrid::interval_only(P.iv - Q.iv);
+}
+
+hybrid operator * (const hybrid & P, const hybrid & Q) {
+    if (P.affine && Q.affine)
+        return hybrid(P.form * Q.form, P.iv * Q.iv);
+    return hybrid::interval_only(P.iv * Q.iv);
+}
+
+hybrid operator / (const hybrid & P, const hybrid & Q) {
+    if (P.affine && Q.affine)
+        return hybrid(P.form / Q.form, P.iv / Q.iv);
+    return hybrid::interval_only(P.iv / Q.iv);
+}
+
+
+// Unary operations
+
+hybrid operator - (const hybrid & P) {
+    if (P.affine)
+        return hybrid(-P.form, -P.iv);
+    return hybrid::interval_only(-P.iv);
+}
+
+hybrid abs(const hybrid & P) {
+    if (P.affine)
+        return hybrid(abs(P.form), abs(P.iv));
+    return hybrid::interval_only(abs(P.iv));
+}
+
+hybrid sqr(const hybrid & P) {
+    if (P.affine)
+        return hybrid(sqr(P.form), sqr(P.iv));
+    return hybrid::interval_only(sqr(P.iv));
+}
+
+hybrid inv(const hybrid & P) {
+    if (P.affine)
+        return hybrid(inv(P.form), inv(P.iv));
+    return hybrid::interval_only(inv(P.iv));
+}
+
+hybrid sqrt(const hybrid & P) {
+    if (P.affine)
+        return hybrid(sqrt(P.form), sqrt(P.iv));
+    return hybrid::interval_only(sqrt(P.iv));
+}
+
+hybrid exp(const hybrid & P) {
+    if (P.affine)
+        return hybrid(exp(P.form), exp(P.iv));
+    return hybrid::interval_only(exp(P.iv));
+}
+
+hybrid log(const hybrid & P) {
+    if (P.affine)
+        return hybrid(log(P.form), log(P.iv));
+    return hybrid::interval_only(log(P.iv));
+}
+
+hybrid pow(const hybrid & P, int n) {
+    if (P.affine)
+        return hybrid(pow(P.form, n), pow(P.iv, n));
+    return hybrid::interval_only(pow(P.iv, n));
+}
+
+hybrid pow(const hybrid & P, double p) {
+    if (P.affine)
+        return hybrid(pow(P.form, p), pow(P.iv, p));
+    return hybrid::interval_only(pow(P.iv, p));
+}
+
+hybrid sin(const hybrid & P) {
+    if (P.affine)
+        return hybrid(sin(P.form), sin(P.iv));
+    return hybrid::interval_only(sin(P.iv));
+}
+
+hybrid cos(const hybrid & P) {
+    if (P.affine)
+        return hybrid(cos(P.form), cos(P.iv));
+    return hybrid::interval_only(cos(P.iv));
+}
+
+
+// Ostream output of a hybrid
+
+std::ostream & operator << (std::ostream & s, const hybrid & P) {
+    s << P.convert();
+    if (P.is_affine())
+        s << " " << P.get_form();
+    return s;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
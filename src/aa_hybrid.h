@@ -0,0 +1,134 @@
+/*
+ * aa_hybrid.h -- Hybrid interval / affine arithmetic class
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_HYBRID_H
+#define AA_HYBRID_H
+
+#include "aa_aaf.h"
+#include "aa_interval.h"
+
+
+// A number carrying both an interval and an affine form
+// Each operation is done in both models and the interval is
+// intersected with the enclosure of the affine form
+// The affine form is dropped (and the number becomes a plain interval)
+// when it is no more worth its cost, see set_drop()
+
+class hybrid
+{
+
+private:
+    static unsigned max_length; // longest affine form we keep
+    static double max_ratio;    // max width(AAF) / width(interval)
+
+    interval iv;  // always valid
+    AAF form;     // only valid if affine is set
+    bool affine;
+
+    hybrid(const AAF & f, const interval & i);
+    static hybrid interval_only(const interval & i);
+
+public:
+
+    hybrid(double v = 0);
+    hybrid(interval i);
+    hybrid(const AAF & f);
+
+    static void set_drop(unsigned length, double ratio);
+
+    interval convert() const;
+    bool is_affine() const;
+    const AAF & get_form() const;
+
+    friend hybrid operator + (const hybrid & P, const hybrid & Q);
+    friend hybrid operator - (const hybrid & P, const hybrid & Q);
+    friend hybrid operator * (const hybrid & P, const hybrid & Q);
+    friend hybrid operator / (const hybrid & P, const hybrid & Q);
+    friend hybrid operator - (const hybrid & P);
+
+    friend hybrid abs(const hybrid & P);
+    friend hybrid sqr(const hybrid & P);
+    friend hybrid inv(const hybrid & P);
+    friend hybrid sqrt(const hybrid & P);
+    friend hybrid exp(const hybrid & P);
+    friend hybrid log(const hybrid & P);
+    friend hybrid pow(const hybrid & P, int n);
+    friend hybrid pow(const hybrid & P, double p);
+    friend hybrid sin(const hybrid & P);
+    friend hybrid cos(const hybrid & P);
+};
+
+hybrid operator + (const hybrid & P, const hybrid & Q);
+hybrid operator - (const hybrid & P, const hybrid & Q);
+hybrid operator * (const hybrid & P, const hybrid & Q);
+hybrid operator / (const hybrid & P, const hybrid & Q);
+hybrid operator - (const hybrid & P);
+
+hybrid abs(const hybrid & P);
+hybrid sqr(const hybrid & P);
+hybrid inv(const hybrid & P);
+hybrid sqrt(const hybrid & P);
+hybrid exp(const hybrid & P);
+hybrid log(const hybrid & P);
+hybrid pow(const hybrid & P, int n);
+hybrid pow(const hybrid & P, double p);
+hybrid sin(const hybrid & P);
+hybrid cos(const hybrid & P);
+
+std::ostream & operator << (std::ostream & s, const hybrid & P);
+
+
+// hybrid inline functions
+
+// Get the enclosure
+
+inline interval hybrid::convert() const {
+    return iv;
+}
+
+
+// Says if we still have an affine form
+
+inline bool hybrid::is_affine() const {
+    return affine;
+}
+
+
+// Get the affine form
+// (the constant 0 if it has been dropped)
+
+inline const AAF & hybrid::get_form() const {
+    return form;
+}
+
+#endif  // AA_HYBRID_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
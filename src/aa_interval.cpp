@@ -23,6 +23,7 @@
 
 #include "aa_interval.h"
 #include "aa_rounding.h"
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <cmath>
@@ -78,41 +79,29 @@ void interval::mod_lo_hi(const double low, const double high) {
 
 // Calculate the midpoint of an interval
 // i.e (lo+hi)/2
+// lo*0.5 and hi*0.5 are exact (but for denormals)
+// so the sum doesn't overflow
 
 double interval::mid() const {
-    double t0,t1;
-
-    aa_rnd_t mode = aa_fegetround();
-
-    aa_fesetround(AA_DOWNWARD);
-    t0 = lo*0.5;
-
-    aa_fesetround(AA_UPWARD);
-    t1 = hi*0.5;
-
-    aa_fesetround(mode);
-
-    return t0 + t1;
+    return lo*0.5 + hi*0.5;
 }
 
 
 // Calculate the radius of an interval
 // i.e (m-lo >=hi-m ? m-lo : hi-m)
+// rounded up so that [m-r,m+r] contains the interval
+// (a difference of doubles is 0 only if it is exact)
 
 double interval::radius() const {
     double m = mid();
 
-    double t0,t1;
+    double t0 = m-lo;
+    double t1 = hi-m;
 
-    aa_rnd_t mode = aa_fegetround();
-
-    aa_fesetround(AA_DOWNWARD);
-    t0 = m-lo;
-
-    aa_fesetround(AA_UPWARD);
-    t1 = hi-m;
-
-    aa_fesetround(mode);
+    if (t0 != 0)
+        t0 = aa_round_up(t0);
+    if (t1 != 0)
+        t1 = aa_round_up(t1);
 
     return (t0 >= t1 ? t0 : t1);
 }
@@ -186,6 +175,303 @@ interval min_trigo( const interval &I) {
     return interval(a,b);
 }
 
+
+// -- Interval arithmetic --
+
+// All the operations are outward rounded : the bounds are computed in
+// the current rounding mode and then moved one step away with
+// aa_round_down() and aa_round_up(), so we never change the mode
+// The libm functions are moved two steps away, as some of them
+// (e.g. the hyperbolics of glibc) are only within two ulps
+
+static double libm_down(double x) {
+    return aa_round_down(aa_round_down(x));
+}
+
+static double libm_up(double x) {
+    return aa_round_up(aa_round_up(x));
+}
+
+
+// An interval with an undefined value (domain error)
+
+static interval nan_interval() {
+    return interval(NAN, NAN);
+}
+
+
+// Outward rounded interval [min(a,b,c,d), max(a,b,c,d)]
+
+static interval hull4(double a, double b, double c, double d) {
+    return interval(aa_round_down(std::min(std::min(a, b), std::min(c, d))),
+                    aa_round_up(std::max(std::max(a, b), std::max(c, d))));
+}
+
+
+// Product for the bounds, with 0*inf = 0
+
+static double bound_mul(double a, double b) {
+    if (a == 0 || b == 0)
+        return 0;
+    return a*b;
+}
+
+
+// Is there a k such that p + k*period is in [a,b] ?
+// When in doubt the answer is yes
+
+static bool has_periodic_point(double a, double b, double p, double period) {
+    const double slack = 4*DBL_EPSILON*(fabs(a) + fabs(b) + period);
+    const double k = floor((a - p)/period);
+
+    for (int i = 0; i < 3; i++) {
+        const double x = p + (k + i)*period;
+        if ((x >= a - slack) && (x <= b + slack))
+            return true;
+    }
+    return false;
+}
+
+
+interval operator + (const interval & I, const interval & J) {
+    return interval(aa_round_down(I.left() + J.left()),
+                    aa_round_up(I.right() + J.right()));
+}
+
+
+interval operator - (const interval & I, const interval & J) {
+    return interval(aa_round_down(I.left() - J.right()),
+                    aa_round_up(I.right() - J.left()));
+}
+
+
+interval operator - (const interval & I) {
+    return interval(-I.right(), -I.left());
+}
+
+
+interval operator * (const interval & I, const interval & J) {
+    return hull4(bound_mul(I.left(), J.left()), bound_mul(I.left(), J.right()),
+                 bound_mul(I.right(), J.left()), bound_mul(I.right(), J.right()));
+}
+
+
+// Division by an interval containing 0 gives the whole line
+
+interval operator / (const interval & I, const interval & J) {
+    if (J.straddles_zero())
+        return interval(-HUGE_VAL, HUGE_VAL);
+
+    return hull4(I.left()/J.left(), I.left()/J.right(),
+                 I.right()/J.left(), I.right()/J.right());
+}
+
+
+interval abs(const interval & I) {
+    if (I.left() >= 0)
+        return I;
+    if (I.right() <= 0)
+        return -I;
+    return interval(0, std::max(-I.left(), I.right()));
+}
+
+
+interval sqr(const interval & I) {
+    const interval a = abs(I);
+    const double lo = a.left()*a.left();
+
+    return interval(lo == 0 ? 0 : aa_round_down(lo),
+                    aa_round_up(a.right()*a.right()));
+}
+
+
+interval inv(const interval & I) {
+    return interval(1.)/I;
+}
+
+
+// sqrt is correctly rounded
+// The negative part of the interval is dropped
+
+interval sqrt(const interval & I) {
+    if (I.right() < 0)
+        return nan_interval();
+
+    const double lo = (I.left() > 0) ? aa_round_down(sqrt(I.left())) : 0;
+
+    return interval(std::max(lo, 0.), aa_round_up(sqrt(I.right())));
+}
+
+
+interval exp(const interval & I) {
+    return interval(std::max(libm_down(exp(I.left())), 0.),
+                    libm_up(exp(I.right())));
+}
+
+
+// The non positive part of the interval is dropped
+
+interval log(const interval & I) {
+    if (I.right() <= 0)
+        return nan_interval();
+
+    const double lo = (I.left() > 0) ? libm_down(log(I.left())) : -HUGE_VAL;
+
+    return interval(lo, libm_up(log(I.right())));
+}
+
+
+// Power function
+// only for integer exponents
+
+interval pow(const interval & I, int n) {
+    if (n == 0)
+        return interval(1.);
+    if (n < 0)
+        return inv(pow(I, -n));
+
+    // x^n is increasing for odd n
+    // and for even n it is increasing with |x|
+
+    interval a = (n & 1) ? I : abs(I);
+    const double lo = pow(a.left(), (double)n);
+
+    return interval((a.left() == 0) ? 0 : libm_down(lo),
+                    libm_up(pow(a.right(), (double)n)));
+}
+
+
+// Power function
+// for real exponents
+// The negative part of the interval is dropped
+
+interval pow(const interval & I, double p) {
+    if ((p == floor(p)) && (fabs(p) <= 1024))
+        return pow(I, (int)p);
+
+    if (I.right() < 0)
+        return nan_interval();
+
+    const double a = std::max(I.left(), 0.);
+    const double b = I.right();
+
+    if (p > 0)
+        return interval(std::max(libm_down(pow(a, p)), 0.),
+                        libm_up(pow(b, p)));
+
+    // decreasing for p < 0
+
+    const double hi = (a == 0) ? HUGE_VAL : libm_up(pow(a, p));
+
+    return interval(std::max(libm_down(pow(b, p)), 0.), hi);
+}
+
+
+// Sine function
+// the maximum is at PI/2 + 2k*PI, the minimum at -PI/2 + 2k*PI
+
+interval sin(const interval & I) {
+    const double a = I.left();
+    const double b = I.right();
+
+    if (!(b - a < 2*M_PI))
+        return interval(-1, 1);
+
+    const double sa = sin(a);
+    const double sb = sin(b);
+
+    double lo = libm_down(std::min(sa, sb));
+    double hi = libm_up(std::max(sa, sb));
+
+    if (has_periodic_point(a, b, M_PI/2, 2*M_PI))
+        hi = 1;
+    if (has_periodic_point(a, b, -M_PI/2, 2*M_PI))
+        lo = -1;
+
+    return interval(std::max(lo, -1.), std::min(hi, 1.));
+}
+
+
+// Cosine function
+// the maximum is at 2k*PI, the minimum at PI + 2k*PI
+
+interval cos(const interval & I) {
+    const double a = I.left();
+    const double b = I.right();
+
+    if (!(b - a < 2*M_PI))
+        return interval(-1, 1);
+
+    const double ca = cos(a);
+    const double cb = cos(b);
+
+    double lo = libm_down(std::min(ca, cb));
+    double hi = libm_up(std::max(ca, cb));
+
+    if (has_periodic_point(a, b, 0, 2*M_PI))
+        hi = 1;
+    if (has_periodic_point(a, b, M_PI, 2*M_PI))
+        lo = -1;
+
+    return interval(std::max(lo, -1.), std::min(hi, 1.));
+}
+
+
+// Tangent function
+// increasing between the poles at PI/2 + k*PI
+
+interval tan(const interval & I) {
+    const double a = I.left();
+    const double b = I.right();
+
+    if (!(b - a < M_PI) || has_periodic_point(a, b, M_PI/2, M_PI))
+        return interval(-HUGE_VAL, HUGE_VAL);
+
+    return interval(libm_down(tan(a)), libm_up(tan(b)));
+}
+
+
+// Hyperbolics
+
+interval cosh(const interval & I) {
+    const interval a = abs(I);
+
+    return interval(std::max(libm_down(cosh(a.left())), 1.),
+                    libm_up(cosh(a.right())));
+}
+
+interval sinh(const interval & I) {
+    return interval(libm_down(sinh(I.left())), libm_up(sinh(I.right())));
+}
+
+interval tanh(const interval & I) {
+    return interval(std::max(libm_down(tanh(I.left())), -1.),
+                    std::min(libm_up(tanh(I.right())), 1.));
+}
+
+interval acosh(const interval & I) {
+    if (I.right() < 1)
+        return nan_interval();
+
+    const double lo = (I.left() > 1) ? libm_down(acosh(I.left())) : 0;
+
+    return interval(std::max(lo, 0.), libm_up(acosh(I.right())));
+}
+
+interval asinh(const interval & I) {
+    return interval(libm_down(asinh(I.left())), libm_up(asinh(I.right())));
+}
+
+interval atanh(const interval & I) {
+    if ((I.right() <= -1) || (I.left() >= 1))
+        return nan_interval();
+
+    const double lo = (I.left() > -1) ? libm_down(atanh(I.left())) : -HUGE_VAL;
+    const double hi = (I.right() < 1) ? libm_up(atanh(I.right())) : HUGE_VAL;
+
+    return interval(lo, hi);
+}
+
 /*
   Local Variables:
   mode:c++
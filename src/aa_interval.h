@@ -31,6 +31,7 @@
 
 // A class for interval representation
 // the class is used by our AAF class
+// It also has its own outward rounded arithmetic (see aa_interval.cpp)
 
 class interval
 {
@@ -42,7 +43,9 @@ class interval
  public:
 
   interval();
+  interval(double v);
   interval(double l, double h);
+  interval(const interval & I);
   interval & operator = (const interval & I);
 
   friend std::istream & operator >> (std::istream & s, interval &I);
@@ -63,9 +66,42 @@ class interval
 std::ostream & operator << (std::ostream & s, const interval &I);
 interval min_trigo( const interval &I);
 
+interval operator + (const interval & I, const interval & J);
+interval operator - (const interval & I, const interval & J);
+interval operator * (const interval & I, const interval & J);
+interval operator / (const interval & I, const interval & J);
+interval operator - (const interval & I);
+
+interval abs(const interval & I);
+interval sqr(const interval & I);
+interval inv(const interval & I);
+interval sqrt(const interval & I);
+interval exp(const interval & I);
+interval log(const interval & I);
+interval pow(const interval & I, int n);
+interval pow(const interval & I, double p);
+interval sin(const interval & I);
+interval cos(const interval & I);
+interval tan(const interval & I);
+
+interval cosh(const interval & I);
+interval sinh(const interval & I);
+interval tanh(const interval & I);
+interval acosh(const interval & I);
+interval asinh(const interval & I);
+interval atanh(const interval & I);
+
 
 // interval inline functions
 
+// Copy constructor (operator = is user declared)
+
+inline interval:: interval(const interval & I):
+     lo(I.lo), hi(I.hi)
+{
+}
+
+
 // Create an interval object
 
 inline interval:: interval(double l, double h):
@@ -74,6 +110,14 @@ inline interval:: interval(double l, double h):
 }
 
 
+// Create the degenerated interval [v,v]
+
+inline interval:: interval(double v):
+     lo(v), hi(v)
+{
+}
+
+
 // Get the lower bound of an interval
 
 inline double interval::left() const
@@ -102,6 +146,42 @@ inline bool interval::straddles_zero() const {
   return (lo <= 0) && (hi >= 0);
 }
 
+
+// Mixed operations with a double
+// (the double is the degenerated interval [v,v])
+
+inline interval operator + (const interval & I, double v) {
+  return I + interval(v);
+}
+
+inline interval operator + (double v, const interval & I) {
+  return interval(v) + I;
+}
+
+inline interval operator - (const interval & I, double v) {
+  return I - interval(v);
+}
+
+inline interval operator - (double v, const interval & I) {
+  return interval(v) - I;
+}
+
+inline interval operator * (const interval & I, double v) {
+  return I * interval(v);
+}
+
+inline interval operator * (double v, const interval & I) {
+  return interval(v) * I;
+}
+
+inline interval operator / (const interval & I, double v) {
+  return I / interval(v);
+}
+
+inline interval operator / (double v, const interval & I) {
+  return interval(v) / I;
+}
+
 #endif  // AA_INTERVAL_H
 /*
   Local Variables:
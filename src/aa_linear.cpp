@@ -0,0 +1,156 @@
+/*
+ * aa_linear.cpp -- Linear part of an AAF and contraction of boxes
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_linear.h"
+#include "aa_rounding.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+// Main noise symbol of P (its largest coefficient is put in coeff)
+// 0 if P is a constant
+
+static aa_symbol main_symbol(const AAF & P, double & coeff) {
+    aa_symbol s = 0;
+    coeff = 0;
+
+    for (unsigned i = 0; i < P.get_length(); i++) {
+        if (fabs(P.get_coeff(i)) > fabs(coeff)) {
+            coeff = P.get_coeff(i);
+            s = P.get_index(i);
+        }
+    }
+
+    return s;
+}
+
+
+// Split f in center + sum grad[i]*(x[i] - x0[i]) + resid*[-1,1]
+// Returns false if f is infinite or nan
+// The rest f - sum grad[i]*x[i] is computed in AA, so the main symbols
+// of the inputs cancel and resid bounds what is left
+
+bool aaf_linearize(const AAF & f, const AAF * x, unsigned n,
+                   double & center, double * grad, double & resid)
+{
+    if (f.is_indeterminate())
+        return false;
+
+    AAF R = f;
+
+    for (unsigned i = 0; i < n; i++) {
+        double b;
+        const aa_symbol s = main_symbol(x[i], b);
+
+        grad[i] = s ? R.index_coeff(s)/b : 0;
+        if (grad[i] != 0)
+            R = R - x[i]*grad[i];
+    }
+
+    if (R.is_indeterminate())
+        return false;
+
+    // the center is summed in interval arithmetic,
+    // its rounding errors go to resid
+
+    interval c(R.get_center());
+    for (unsigned i = 0; i < n; i++)
+        c = c + interval(grad[i])*interval(x[i].get_center());
+
+    center = c.mid();
+    resid = aa_round_up(R.rad() + aa_round_up(std::max(center - c.left(),
+                                                       c.right() - center)));
+    return true;
+}
+
+
+// Intersection of I and J in I, false if it's empty
+
+static bool intersect(interval & I, const interval & J) {
+    const double lo = std::max(I.left(), J.left());
+    const double hi = std::min(I.right(), J.right());
+
+    if (!(lo <= hi))
+        return false;
+
+    I = interval(lo, hi);
+    return true;
+}
+
+
+// Contract box to the points where f can be in [lo,hi] :
+// grad[i]*(x[i] - x0[i]) is in [lo,hi] - center - [-resid,resid]
+// minus the other terms, each input is bounded in turn (and its new
+// range used for the next ones)
+
+bool aaf_contract(const AAF & f, const AAF * x, interval * box, unsigned n,
+                  double lo, double hi)
+{
+    std::vector<double> grad(n + 1);
+    double c, r;
+
+    if (!aaf_linearize(f, x, n, c, &grad[0], r))
+        return true;  // nothing known about f
+
+    const interval target = interval(lo, hi) - interval(c) - interval(-r, r);
+
+    std::vector<interval> term(n + 1);
+    for (unsigned i = 0; i < n; i++)
+        term[i] = interval(grad[i])*(box[i] - interval(x[i].get_center()));
+
+    for (unsigned i = 0; i < n; i++) {
+        if (grad[i] == 0)
+            continue;
+
+        interval S = target;
+        for (unsigned j = 0; j < n; j++)
+            if (j != i)
+                S = S - term[j];
+
+        const interval X = interval(x[i].get_center()) + S/interval(grad[i]);
+        if (!intersect(box[i], X))
+            return false;
+
+        term[i] = interval(grad[i])*(box[i] - interval(x[i].get_center()));
+    }
+
+    // the sum must still reach the target
+
+    interval S(0.);
+    for (unsigned j = 0; j < n; j++)
+        S = S + term[j];
+
+    return intersect(S, target);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,67 @@
+/*
+ * aa_linear.h -- Linear part of an AAF and contraction of boxes
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_LINEAR_H
+#define AA_LINEAR_H
+
+#include "aa_aaf.h"
+#include "aa_interval.h"
+
+
+// An AAF f computed from the inputs x[0] ... x[n-1] is a linear
+// function of them plus error terms :
+//
+//   f = center + grad[0]*(x[0] - x0[0]) + ... + resid*[-1,1]
+//
+// where x0 are the centers of the inputs
+// The gradient is taken on the main noise symbol of each input (its
+// largest coefficient), the rest of f, the other symbols of the
+// inputs included, is bounded by resid
+//
+//   AAF x[2] = { AAF(interval(1, 2)), AAF(interval(0, 1)) };
+//   AAF f = x[0]*x[1] - 1;
+//   aaf_linearize(f, x, 2, c, g, r);
+
+bool aaf_linearize(const AAF & f, const AAF * x, unsigned n,
+                   double & center, double * grad, double & resid);
+
+
+// Contract the box of the inputs x[0] ... x[n-1] (x[i] is in box[i])
+// to the points where f can be in [lo,hi], from the linear part of f
+// Returns false if there is no such point in the box
+// The box can be contracted again after f is evaluated on it
+
+bool aaf_contract(const AAF & f, const AAF * x, interval * box, unsigned n,
+                  double lo, double hi);
+
+#endif  // AA_LINEAR_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
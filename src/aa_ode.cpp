@@ -0,0 +1,295 @@
+/*
+ * aa_ode.cpp -- Validated integration of ODEs on affine forms
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_ode.h"
+#include "aa_util.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <utility>
+#include <vector>
+
+
+// Says if I is inside J
+
+static bool inside(const interval & I, const interval & J) {
+    return (I.left() >= J.left()) && (I.right() <= J.right());
+}
+
+
+// Hull of I and J, widened by a tenth of its width
+// (so that the Picard iteration ends quickly when it can)
+
+static interval widen(const interval & I, const interval & J) {
+    const double lo = std::min(I.left(), J.left());
+    const double hi = std::max(I.right(), J.right());
+    const double w = 0.1*(hi - lo) + DBL_EPSILON*(fabs(lo) + fabs(hi)) + DBL_MIN;
+    return interval(lo - w, hi + w);
+}
+
+
+// Create an integrator for a system of size n
+
+aa_ode::aa_ode(unsigned n, aa_ode_rhs f, void * data)
+    : n(n), f(f), data(data), h(1e-2), hmin(1e-10), hmax(1), tol(1e-3), keep(0),
+      max_iter(10)
+{
+    enc = new AAF [n];
+    dy = new AAF [n];
+    next = new AAF [n];
+    F = new interval [n];
+    r0 = new double [n];
+    range = new interval [n];
+}
+
+
+aa_ode::~aa_ode() {
+    delete [] range;
+    delete [] r0;
+    delete [] F;
+    delete [] next;
+    delete [] dy;
+    delete [] enc;
+}
+
+
+// First step, and bounds of the step
+
+void aa_ode::set_step(double h0, double min, double max) {
+    h = h0;
+    hmin = min;
+    hmax = max;
+}
+
+
+// Width the method may add to the state per unit of time
+
+void aa_ode::set_tolerance(double t) {
+    tol = t;
+}
+
+
+// Condense the state to its keep main noise symbols after each step
+// (0 keeps all of them)
+
+void aa_ode::set_condense(unsigned k) {
+    keep = k;
+}
+
+
+// Find F such that every solution starting in y stays in
+// y + [0,step]*F over [t,t+step] : this is the case when
+// f([t,t+step], y + [0,step]*F) is inside F
+// On success enc is the enclosure and dy = f over it
+// (and r0 has the radii of f(t,y))
+
+bool aa_ode::enclose(double t, double step, const AAF * y) {
+    f(AAF(t), y, dy, data);
+    for (unsigned i = 0; i < n; i++) {
+        r0[i] = dy[i].rad();
+        F[i] = widen(dy[i].convert(), dy[i].convert());
+    }
+
+    const AAF T(interval(t, t + step));
+
+    for (unsigned it = 0; it < max_iter; it++) {
+        for (unsigned i = 0; i < n; i++)
+            enc[i] = y[i] + AAF(interval(0, step)*F[i]);
+
+        f(T, enc, dy, data);
+
+        bool ok = true;
+        for (unsigned i = 0; i < n; i++) {
+            const interval G = dy[i].convert();
+            if (dy[i].is_indeterminate())
+                return false;
+            if (!inside(G, F[i])) {
+                F[i] = widen(F[i], G);
+                ok = false;
+            }
+        }
+
+        if (ok)
+            return true;
+    }
+
+    return false;
+}
+
+
+// One step from t (at most up to tmax)
+// y is replaced by the enclosure of the solutions at the new t
+// Returns false if no step of at least hmin could be done
+
+bool aa_ode::step(double & t, AAF * y, double tmax) {
+    while (true) {
+        const bool last = (t + h >= tmax);
+        const double hh = last ? tmax - t : h;
+        if (!(hh > 0))
+            return false;
+
+        if (!enclose(t, hh, y)) {
+            if (hh/2 < hmin)
+                return false;
+            h = hh/2;
+            continue;
+        }
+
+        // Width added by the step : f over [t,t+h] is wider than f(t,y)
+
+        double added = 0;
+        for (unsigned i = 0; i < n; i++) {
+            next[i] = y[i] + dy[i]*hh;
+            added = std::max(added, hh*(dy[i].rad() - r0[i]));
+        }
+
+        if ((added > tol*hh) && (hh/2 >= hmin)) {
+            h = hh/2;
+            continue;
+        }
+
+        for (unsigned i = 0; i < n; i++) {
+            range[i] = enc[i].convert();
+            y[i] = next[i];
+        }
+
+        t = last ? tmax : t + hh;
+        if (!last && (added < tol*hh/4))
+            h = std::min(2*h, hmax);
+
+        if (keep)
+            aaf_condense(y, n, keep);
+
+        return true;
+    }
+}
+
+
+// Integrate from t up to tmax, calling obs after each step
+// Returns false (with t where it stopped) if a step failed
+
+bool aa_ode::integrate(double & t, double tmax, AAF * y,
+                       aa_ode_observer obs, void * obs_data)
+{
+    while (t < tmax) {
+        const double t0 = t;
+        if (!step(t, y, tmax))
+            return false;
+        if (obs)
+            obs(t0, t - t0, range, y, n, obs_data);
+    }
+
+    return true;
+}
+
+
+// Condense y[0] ... y[n-1] : only the keep noise symbols with the
+// largest coefficients (summed over the n forms) are kept, the other
+// terms of each form are replaced by a single new noise symbol
+// The forms then have at most keep+1 terms, and keep their
+// correlations through the symbols kept
+
+void aaf_condense(AAF * y, unsigned n, unsigned keep) {
+    // weight of each symbol
+
+    std::vector<std::pair<aa_symbol, double> > terms;
+    for (unsigned i = 0; i < n; i++) {
+        if (y[i].is_indeterminate())
+            continue;
+        for (unsigned j = 0; j < y[i].get_length(); j++)
+            terms.push_back(std::make_pair(y[i].get_index(j), fabs(y[i].get_coeff(j))));
+    }
+    std::sort(terms.begin(), terms.end());
+
+    std::vector<std::pair<double, aa_symbol> > weight;
+    for (unsigned k = 0; k < terms.size(); k++) {
+        if (weight.empty() || (weight.back().second != terms[k].first))
+            weight.push_back(std::make_pair(0., terms[k].first));
+        weight.back().first += terms[k].second;
+    }
+
+    if (weight.size() <= keep)
+        return;
+
+    std::nth_element(weight.begin(), weight.begin() + keep, weight.end(),
+                     std::greater<std::pair<double, aa_symbol> >());
+
+    std::vector<aa_symbol> kept;
+    for (unsigned k = 0; k < keep; k++)
+        kept.push_back(weight[k].second);
+    std::sort(kept.begin(), kept.end());
+
+    // rebuild the forms
+
+    std::vector<double> coeffs;
+    std::vector<aa_symbol> ids;
+
+    for (unsigned i = 0; i < n; i++) {
+        if (y[i].is_indeterminate())
+            continue;
+
+        coeffs.clear();
+        ids.clear();
+        aa_roundoff ro;
+        double rest = 0;
+        bool dropped = false;
+
+        for (unsigned j = 0; j < y[i].get_length(); j++) {
+            if (std::binary_search(kept.begin(), kept.end(), y[i].get_index(j))) {
+                ids.push_back(y[i].get_index(j));
+                coeffs.push_back(y[i].get_coeff(j));
+            } else {
+                rest = ro.add(rest, fabs(y[i].get_coeff(j)));
+                dropped = true;
+            }
+        }
+
+        if (!dropped)
+            continue;
+
+        rest = ro.error(rest, 0);
+        if (rest > 0) {
+            ids.push_back(AAF::inclast());
+            coeffs.push_back(rest);
+            AA_STAT_SYMBOL();
+            AA_TAG_SYMBOL(ids.back(), "condense");
+        }
+
+        if (ids.empty())
+            y[i] = AAF(y[i].get_center());
+        else
+            y[i] = AAF(y[i].get_center(), &coeffs[0], &ids[0], ids.size());
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,129 @@
+/*
+ * aa_ode.h -- Validated integration of ODEs on affine forms
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_ODE_H
+#define AA_ODE_H
+
+#include "aa_aaf.h"
+#include "aa_interval.h"
+
+
+// Right-hand side of the system y' = f(t, y) of size n :
+// fills dy[0] ... dy[n-1] from t and y[0] ... y[n-1]
+
+typedef void (*aa_ode_rhs)(const AAF & t, const AAF * y, AAF * dy, void * data);
+
+// Called after each step from t to t+h with the enclosure of the
+// solution over [t,t+h] (range) and the new state y
+
+typedef void (*aa_ode_observer)(double t, double h, const interval * range,
+                                const AAF * y, unsigned n, void * data);
+
+
+// Integrator of y' = f(t, y) from an uncertain initial state
+//
+// Each step first finds an a priori enclosure y + [0,h]*F of the
+// solutions over [t,t+h] (Picard iteration on F), then the new state
+// is y + h*f([t,t+h], y + [0,h]*F) : every solution starting in y is
+// in it, and it keeps the noise symbols of y so the correlations
+// between the components and with the initial state are not lost
+// This is a first order method : the width it adds to f(t,y)*h is
+// about h^2 per step, h is halved when it is more than tol*h and
+// doubled when it's well below (up to hmax)
+//
+// With set_condense(keep) the state is condensed after each step (see
+// aaf_condense) so its length, the cost of a step and the memory used
+// stay the same over any number of steps
+
+class aa_ode
+{
+
+private:
+    unsigned n;        // size of the system
+    aa_ode_rhs f;
+    void * data;
+
+    double h, hmin, hmax;  // current step and its bounds
+    double tol;            // width added per unit of time
+    unsigned keep;         // symbols kept by the condensation, 0 for all
+    unsigned max_iter;     // Picard iterations before halving h
+
+    AAF * enc;         // a priori enclosure y + [0,h]*F
+    AAF * dy;          // f over enc
+    AAF * next;        // state after the step
+    interval * F;
+    double * r0;       // radii of f(t,y)
+    interval * range;  // enclosure over the last step
+
+    bool enclose(double t, double step, const AAF * y);
+
+    aa_ode(const aa_ode &);
+    aa_ode & operator = (const aa_ode &);
+
+public:
+
+    aa_ode(unsigned n, aa_ode_rhs f, void * data = NULL);
+    ~aa_ode();
+
+    void set_step(double h0, double hmin, double hmax);
+    void set_tolerance(double tol);
+    void set_condense(unsigned keep);
+
+    double get_step() const;
+    const interval * get_range() const;
+
+    bool step(double & t, AAF * y, double tmax);
+    bool integrate(double & t, double tmax, AAF * y,
+                   aa_ode_observer obs = NULL, void * obs_data = NULL);
+};
+
+
+void aaf_condense(AAF * y, unsigned n, unsigned keep);
+
+
+// aa_ode inline functions
+
+// The step the next call of step() will try first
+
+inline double aa_ode::get_step() const {
+    return h;
+}
+
+
+// The enclosure of the solution over the last step
+
+inline const interval * aa_ode::get_range() const {
+    return range;
+}
+
+#endif  // AA_ODE_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
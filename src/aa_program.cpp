@@ -0,0 +1,787 @@
+/*
+ * aa_program.cpp -- Recorded AAF programs and their parallel evaluation
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_program.h"
+#include "aa_rounding.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <pthread.h>
+#include <sched.h>
+
+
+// Record a new input, the i-th one is x[i] of evaluate()
+
+aaf_expr aa_program::input() {
+    node k;
+    k.op = AA_PROG_INPUT;
+    k.arg[0] = k.arg[1] = 0;
+    k.n = inputs.size();
+    k.p = 0;
+
+    inputs.push_back(nodes.size());
+    return push(k);
+}
+
+
+// Make f an output of the program, returns its index in y of
+// evaluate()
+
+unsigned aa_program::output(const aaf_expr & f) {
+    outputs.push_back(place(f));
+    return outputs.size() - 1;
+}
+
+
+// Forget everything (the aaf_exprs of the program can't be used
+// anymore)
+
+void aa_program::clear() {
+    nodes.clear();
+    constants.clear();
+    inputs.clear();
+    outputs.clear();
+    recorded.clear();
+    scalars.clear();
+}
+
+
+unsigned aa_program::get_inputs() const {
+    return inputs.size();
+}
+
+unsigned aa_program::get_outputs() const {
+    return outputs.size();
+}
+
+
+// Number of operations recorded, the inputs and constants included
+
+unsigned aa_program::size() const {
+    return nodes.size();
+}
+
+
+// Number of threads of evaluate()
+
+void aa_program::set_threads(unsigned n) {
+    threads = n ? n : 1;
+}
+
+
+// Rewrite the operations recorded from now on (see aa_program.h)
+
+void aa_program::set_rewrite(bool on) {
+    rewrite = on;
+}
+
+
+// (the exponents of pow are compared by their bits, as the constants
+// in place(), so that a NaN keeps the order strict)
+
+bool aa_program::node::operator < (const node & k) const {
+    if (op != k.op)
+        return op < k.op;
+    if (arg[0] != k.arg[0])
+        return arg[0] < k.arg[0];
+    if (arg[1] != k.arg[1])
+        return arg[1] < k.arg[1];
+    if (n != k.n)
+        return n < k.n;
+    uint64_t b1, b2;
+    memcpy(&b1, &p, sizeof b1);
+    memcpy(&b2, &k.p, sizeof b2);
+    return b1 < b2;
+}
+
+
+aaf_expr aa_program::push(const node & k) {
+    nodes.push_back(k);
+    return aaf_expr(this, nodes.size() - 1);
+}
+
+aaf_expr aa_program::ref(unsigned k) {
+    return aaf_expr(this, k);
+}
+
+
+// Says if node k is a constant of no noise symbol, of value c
+
+bool aa_program::scalar(unsigned k, double & c) const {
+    const node & d = nodes[k];
+    if (d.op != AA_PROG_CONST)
+        return false;
+
+    const AAF & v = constants[d.n];
+    if (v.get_length() || v.is_indeterminate())
+        return false;
+    c = v.get_center();
+    return true;
+}
+
+
+// The node of e, a constant is recorded first (once for each value
+// when it has no noise symbol)
+// The values are told apart by their bits, so that 0 and -0 are
+// different constants and a NaN doesn't break the order of the map
+
+unsigned aa_program::place(const aaf_expr & e) {
+    if (!e.is_constant())
+        return e.node;
+
+    const bool plain = !e.cst.get_length() && !e.cst.is_indeterminate();
+    const double c = e.cst.get_center();
+    uint64_t bits;
+    memcpy(&bits, &c, sizeof bits);
+    if (plain) {
+        std::map<uint64_t, unsigned>::const_iterator i = scalars.find(bits);
+        if (i != scalars.end())
+            return i->second;
+    }
+
+    node k;
+    k.op = AA_PROG_CONST;
+    k.arg[0] = k.arg[1] = 0;
+    k.n = constants.size();
+    k.p = 0;
+
+    constants.push_back(e.cst);
+    push(k);
+    if (plain)
+        scalars[bits] = nodes.size() - 1;
+    return nodes.size() - 1;
+}
+
+
+// Record the operation k, unless it is rewritten or it is already
+// recorded
+
+aaf_expr aa_program::record(node k) {
+    if ((k.op == AA_PROG_ADD || k.op == AA_PROG_MUL) && k.arg[1] < k.arg[0])
+        std::swap(k.arg[0], k.arg[1]);
+
+    aaf_expr e;
+    if (rewrite && simplify(k, e))
+        return e;
+
+    std::map<node, unsigned>::const_iterator i = recorded.find(k);
+    if (i != recorded.end())
+        return ref(i->second);
+
+    recorded[k] = nodes.size();
+    return push(k);
+}
+
+
+// The rewrites of aa_program.h, k being written as e
+// (the operations of e are recorded on their own)
+
+bool aa_program::simplify(const node & k, aaf_expr & e) {
+    const unsigned a = k.arg[0], b = k.arg[1];
+    const aaf_expr x = ref(a);
+    double c;
+
+    switch (k.op) {
+    case AA_PROG_ADD:
+        if (scalar(b, c) && c == 0)
+            e = x;
+        else if (scalar(a, c) && c == 0)
+            e = ref(b);
+        else
+            return false;
+        return true;
+
+    case AA_PROG_SUB:
+        if (scalar(b, c) && c == 0)
+            e = x;
+        else if (scalar(a, c) && c == 0)
+            e = -ref(b);
+        else
+            return false;
+        return true;
+
+    case AA_PROG_NEG:
+        if (nodes[a].op != AA_PROG_NEG)
+            return false;
+        e = ref(nodes[a].arg[0]);
+        return true;
+
+    case AA_PROG_MUL: {
+        if (scalar(b, c) && c == 1) {
+            e = x;
+            return true;
+        }
+        if (scalar(a, c) && c == 1) {
+            e = ref(b);
+            return true;
+        }
+        if (scalar(a, c) || scalar(b, c))
+            return false;
+        if (a == b) {
+            e = sqr(x);
+            return true;
+        }
+
+        // c*u*v is c*(u*v), so that u*v may be shared
+
+        for (unsigned j = 0; j < 2; j++) {
+            const node & m = nodes[k.arg[j]];
+            if (m.op != AA_PROG_MUL)
+                continue;
+            for (unsigned i = 0; i < 2; i++) {
+                if (scalar(m.arg[i], c)) {
+                    e = aaf_expr(c)*(ref(m.arg[1-i])*ref(k.arg[1-j]));
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    case AA_PROG_DIV:
+        if (!scalar(b, c) || c != 1)
+            return false;
+        e = x;
+        return true;
+
+    // the squarings of pow(AAF, int)
+
+    case AA_PROG_POWI:
+        if (k.n == 0) {
+            e = aaf_expr(1.);
+        } else if (k.n == 1) {
+            e = x;
+        } else if (k.n < 0) {
+            e = inv(pow(x, -k.n));
+        } else {
+            const aaf_expr h = sqr(pow(x, k.n/2));
+            e = (k.n & 1) ? h*x : h;
+        }
+        return true;
+
+    // the formulas of the library, with the exps shared
+
+    case AA_PROG_TAN:
+        e = sin(x)/cos(x);
+        return true;
+    case AA_PROG_COSH:
+        e = (exp(x) + exp(-x))/2.;
+        return true;
+    case AA_PROG_SINH:
+        e = (exp(x) - exp(-x))/2.;
+        return true;
+    case AA_PROG_TANH:
+        e = (exp(x) - exp(-x))/(exp(x) + exp(-x));
+        return true;
+    case AA_PROG_ACOSH:
+        e = log(x + sqrt(sqr(x) - 1.));
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+// An operation on constants is done at once
+
+aaf_expr aa_program::unary(aa_program_op op, const aaf_expr & u, int n, double p) {
+    node k;
+    k.op = op;
+    k.n = n;
+    k.p = p;
+
+    if (u.is_constant()) {
+        const bool c = !u.cst.get_length() && !u.cst.is_indeterminate();
+        return aaf_expr(apply(k, u.cst, u.cst, c, c));
+    }
+
+    k.arg[0] = k.arg[1] = u.node;
+    return u.prog->record(k);
+}
+
+aaf_expr aa_program::binary(aa_program_op op, const aaf_expr & a, const aaf_expr & b) {
+    node k;
+    k.op = op;
+    k.n = 0;
+    k.p = 0;
+
+    if (a.is_constant() && b.is_constant()) {
+        const bool ca = !a.cst.get_length() && !a.cst.is_indeterminate();
+        const bool cb = !b.cst.get_length() && !b.cst.is_indeterminate();
+        return aaf_expr(apply(k, a.cst, b.cst, ca, cb));
+    }
+
+    aa_program * prog = a.is_constant() ? b.prog : a.prog;
+    k.arg[0] = prog->place(a);
+    k.arg[1] = prog->place(b);
+    return prog->record(k);
+}
+
+
+// Number of noise symbols an operation may need (an operation needing
+// more is done again, see evaluate)
+
+unsigned aa_program::symbols(const node & k) {
+    switch (k.op) {
+    case AA_PROG_INPUT:
+    case AA_PROG_CONST:
+        return 0;
+    case AA_PROG_DIV:
+    case AA_PROG_COS:
+        return 2;
+    case AA_PROG_SINH:
+    case AA_PROG_COSH:
+        return 4;
+    case AA_PROG_ASINH:
+        return 5;
+    case AA_PROG_TAN:
+    case AA_PROG_TANH:
+    case AA_PROG_ACOSH:
+        return 6;
+    case AA_PROG_POWI: {
+        unsigned bits = 0;
+        for (unsigned m = (k.n < 0) ? -k.n : k.n; m; m >>= 1)
+            bits++;
+        return 2*bits + 2;
+    }
+    default:
+        return 1;
+    }
+}
+
+
+// The operation k on a and b (ca and cb say if they are constants,
+// which are then used as doubles)
+
+AAF aa_program::apply(const node & k, const AAF & a, const AAF & b, bool ca, bool cb) {
+    switch (k.op) {
+    case AA_PROG_ADD:
+        if (ca)
+            return a.get_center() + b;
+        if (cb)
+            return a + b.get_center();
+        return a + b;
+    case AA_PROG_SUB:
+        if (ca)
+            return a.get_center() - b;
+        if (cb)
+            return a - b.get_center();
+        return a - b;
+    case AA_PROG_NEG:
+        return -a;
+    case AA_PROG_MUL:
+        if (ca)
+            return b*a.get_center();
+        if (cb)
+            return a*b.get_center();
+        return a*b;
+    case AA_PROG_DIV:
+        if (cb)
+            return a/b.get_center();
+        if (ca)
+            return a.get_center()/b;
+        return a/b;
+    case AA_PROG_SQR:
+        return sqr(a);
+    case AA_PROG_SQRT:
+        return sqrt(a);
+    case AA_PROG_INV:
+        return inv(a);
+    case AA_PROG_EXP:
+        return exp(a);
+    case AA_PROG_LOG:
+        return log(a);
+    case AA_PROG_POWI:
+        return pow(a, k.n);
+    case AA_PROG_POW:
+        return pow(a, k.p);
+    case AA_PROG_ABS:
+        return abs(a);
+    case AA_PROG_SIN:
+        return sin(a);
+    case AA_PROG_COS:
+        return cos(a);
+    case AA_PROG_TAN:
+        return tan(a);
+    case AA_PROG_SINH:
+        return sinh(a);
+    case AA_PROG_COSH:
+        return cosh(a);
+    case AA_PROG_TANH:
+        return tanh(a);
+    case AA_PROG_ASINH:
+        return asinh(a);
+    case AA_PROG_ACOSH:
+        return acosh(a);
+    default:
+        return a;
+    }
+}
+
+
+// The operations ready to be evaluated by a thread
+
+struct aa_program_queue
+{
+    pthread_mutex_t lock;
+    std::deque<unsigned> ready;
+};
+
+static void give(aa_program_queue & q, unsigned k) {
+    pthread_mutex_lock(&q.lock);
+    q.ready.push_back(k);
+    pthread_mutex_unlock(&q.lock);
+}
+
+// The last one given to q, or the first one when it is stolen
+
+static bool take(aa_program_queue & q, bool steal, unsigned & k) {
+    pthread_mutex_lock(&q.lock);
+    const bool found = !q.ready.empty();
+    if (found) {
+        if (steal) {
+            k = q.ready.front();
+            q.ready.pop_front();
+        } else {
+            k = q.ready.back();
+            q.ready.pop_back();
+        }
+    }
+    pthread_mutex_unlock(&q.lock);
+    return found;
+}
+
+
+// An evaluation of the program
+
+struct aa_program::run
+{
+    const aa_program * p;
+    std::vector<const AAF *> value;      // of each node
+    std::vector<AAF> result;             // of each operation
+    std::vector<bool> scalar;            // constant of no noise symbol
+    std::vector<aa_symbol> block;        // first symbol of each operation
+    std::vector<unsigned> pending;       // operands not evaluated yet
+    std::vector<unsigned> first_user;    // the operations using k are
+    std::vector<unsigned> users;         // users[first_user[k] ...]
+    std::vector<aa_program_queue> queues;
+    unsigned left;                       // operations not evaluated yet
+    unsigned threads;                    // (their queue is queues[threads++])
+    unsigned overflow;                   // (set by any thread)
+    bool up;                             // evaluate() is in an aa_rounding_scope
+
+    void step(unsigned k);
+};
+
+void aa_program::run::step(unsigned k) {
+    const node & d = p->nodes[k];
+    AAF::use_block(block[k], symbols(d));
+    result[k] = apply(d, *value[d.arg[0]], *value[d.arg[1]],
+                      scalar[d.arg[0]], scalar[d.arg[1]]);
+    if (AAF::block_overflow())
+        __sync_fetch_and_or(&overflow, 1u);
+
+    // (the radius is cached before the users of k can read result[k]
+    // on other threads)
+
+    result[k].rad();
+    value[k] = &result[k];
+}
+
+
+// Evaluate the operations of the queue of this thread, or of the
+// queues of the others, until they are all done
+
+void * aa_program::work(void * arg) {
+    run & r = *(run *)arg;
+
+    if (r.up && !aa_rounding_scope::active()) {
+        aa_rounding_scope scope;
+        return work(arg);
+    }
+
+    const unsigned n = r.queues.size();
+    const unsigned me = __sync_fetch_and_add(&r.threads, 1);
+
+    while (__sync_fetch_and_add(&r.left, 0)) {
+        unsigned k;
+        bool found = take(r.queues[me], false, k);
+        for (unsigned t = 1; !found && t < n; t++)
+            found = take(r.queues[(me + t) % n], true, k);
+        if (!found) {
+            sched_yield();
+            continue;
+        }
+
+        r.step(k);
+        for (unsigned u = r.first_user[k]; u < r.first_user[k+1]; u++)
+            if (!__sync_sub_and_fetch(&r.pending[r.users[u]], 1))
+                give(r.queues[me], r.users[u]);
+        __sync_sub_and_fetch(&r.left, 1);
+    }
+
+    AAF::use_block(0, 0);
+    return NULL;
+}
+
+
+// The outputs of the program for the inputs x[0] ... x[n-1] in
+// y[0] ... y[m-1]
+// Only the operations the outputs depend on are evaluated, each one
+// with noise symbols from its own block (in the order of the
+// operations) : when an operation needs more symbols than its block
+// holds, they are all done again by this thread with the next
+// symbols in use
+
+void aa_program::evaluate(const AAF * x, AAF * y) const {
+    const unsigned n = nodes.size();
+    run r;
+    r.p = this;
+    r.value.resize(n, (const AAF *)NULL);
+    r.result.resize(n);
+    r.scalar.resize(n, false);
+    r.block.resize(n, 0);
+    r.pending.resize(n, 0);
+    r.first_user.resize(n + 1, 0);
+    r.left = 0;
+    r.threads = 0;
+    r.overflow = 0;
+    r.up = aa_rounding_scope::active();
+
+    std::vector<bool> needed(n, false);
+    for (unsigned j = 0; j < outputs.size(); j++)
+        needed[outputs[j]] = true;
+
+    // The inputs and the constants are known (with their radius cached,
+    // so that the threads only read them), the others count their
+    // operands (twice for x*x) and are counted by them
+
+    for (unsigned k = n; k-- > 0; ) {
+        if (!needed[k])
+            continue;
+        const node & d = nodes[k];
+        if (d.op == AA_PROG_INPUT) {
+            r.value[k] = &x[d.n];
+        } else if (d.op == AA_PROG_CONST) {
+            r.value[k] = &constants[d.n];
+            r.scalar[k] = !constants[d.n].get_length() && !constants[d.n].is_indeterminate();
+        }
+        if (r.value[k]) {
+            r.value[k]->rad();
+        } else {
+            for (unsigned j = 0; j < 2; j++) {
+                needed[d.arg[j]] = true;
+                r.first_user[d.arg[j]]++;
+            }
+        }
+    }
+
+    std::vector<unsigned> ops;
+    aa_symbol total = 0;
+    for (unsigned k = 0; k < n; k++) {
+        if (!needed[k] || r.value[k])
+            continue;
+        ops.push_back(k);
+        r.block[k] = total;
+        total += symbols(nodes[k]);
+    }
+
+    const aa_symbol first = total ? AAF::reserve_block(total) : 1;
+    for (unsigned i = 0; i < ops.size(); i++)
+        r.block[ops[i]] += first;
+
+    // first_user[k] is the end of the users of k, and then their
+    // beginning once they are filled
+
+    for (unsigned k = 0; k < n; k++)
+        r.first_user[k+1] += r.first_user[k];
+    r.users.resize(r.first_user[n]);
+    for (unsigned i = ops.size(); i-- > 0; ) {
+        const node & d = nodes[ops[i]];
+        for (unsigned j = 0; j < 2; j++) {
+            r.users[--r.first_user[d.arg[j]]] = ops[i];
+            if (!r.value[d.arg[j]])
+                r.pending[ops[i]]++;
+        }
+    }
+
+    // (this thread is one of them)
+
+    const unsigned nt = std::max(1u, std::min(threads, (unsigned)ops.size()));
+    if (nt == 1) {
+        for (unsigned i = 0; i < ops.size(); i++)
+            r.step(ops[i]);
+        AAF::use_block(0, 0);
+    } else {
+        r.queues.resize(nt);
+        for (unsigned t = 0; t < nt; t++)
+            pthread_mutex_init(&r.queues[t].lock, NULL);
+
+        unsigned ready = 0;
+        for (unsigned i = 0; i < ops.size(); i++)
+            if (!r.pending[ops[i]])
+                r.queues[ready++ % nt].ready.push_back(ops[i]);
+        r.left = ops.size();
+
+        std::vector<pthread_t> id(nt);
+        unsigned started = 0;
+        for (unsigned t = 1; t < nt; t++)
+            if (!pthread_create(&id[started], NULL, work, &r))
+                started++;
+        work(&r);
+        for (unsigned t = 0; t < started; t++)
+            pthread_join(id[t], NULL);
+
+        for (unsigned t = 0; t < nt; t++)
+            pthread_mutex_destroy(&r.queues[t].lock);
+    }
+
+    if (r.overflow) {
+        for (unsigned i = 0; i < ops.size(); i++) {
+            const node & d = nodes[ops[i]];
+            r.result[ops[i]] = apply(d, *r.value[d.arg[0]], *r.value[d.arg[1]],
+                                     r.scalar[d.arg[0]], r.scalar[d.arg[1]]);
+        }
+    }
+
+    for (unsigned j = 0; j < outputs.size(); j++)
+        y[j] = *r.value[outputs[j]];
+}
+
+
+// Arithmetic
+
+aaf_expr operator + (const aaf_expr & a, const aaf_expr & b) {
+    return aa_program::binary(AA_PROG_ADD, a, b);
+}
+
+aaf_expr operator - (const aaf_expr & a, const aaf_expr & b) {
+    return aa_program::binary(AA_PROG_SUB, a, b);
+}
+
+aaf_expr operator - (const aaf_expr & a) {
+    return aa_program::unary(AA_PROG_NEG, a);
+}
+
+aaf_expr operator * (const aaf_expr & a, const aaf_expr & b) {
+    return aa_program::binary(AA_PROG_MUL, a, b);
+}
+
+aaf_expr operator / (const aaf_expr & a, const aaf_expr & b) {
+    return aa_program::binary(AA_PROG_DIV, a, b);
+}
+
+
+// Elementary functions
+
+aaf_expr sqr(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_SQR, u);
+}
+
+aaf_expr sqrt(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_SQRT, u);
+}
+
+aaf_expr inv(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_INV, u);
+}
+
+aaf_expr exp(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_EXP, u);
+}
+
+aaf_expr log(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_LOG, u);
+}
+
+aaf_expr pow(const aaf_expr & u, int n) {
+    return aa_program::unary(AA_PROG_POWI, u, n);
+}
+
+// (an integer exponent is pow(AAF, int), whose squarings need the
+// block of AA_PROG_POWI, see pow(AAF, double))
+
+aaf_expr pow(const aaf_expr & u, double p) {
+    if ((p == floor(p)) && (fabs(p) <= 1024))
+        return aa_program::unary(AA_PROG_POWI, u, (int)p);
+    return aa_program::unary(AA_PROG_POW, u, 0, p);
+}
+
+aaf_expr abs(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_ABS, u);
+}
+
+aaf_expr sin(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_SIN, u);
+}
+
+aaf_expr cos(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_COS, u);
+}
+
+aaf_expr tan(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_TAN, u);
+}
+
+aaf_expr sinh(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_SINH, u);
+}
+
+aaf_expr cosh(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_COSH, u);
+}
+
+aaf_expr tanh(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_TANH, u);
+}
+
+aaf_expr asinh(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_ASINH, u);
+}
+
+aaf_expr acosh(const aaf_expr & u) {
+    return aa_program::unary(AA_PROG_ACOSH, u);
+}
+
+
+// P[0] + ... + P[n-1] as a balanced tree of sums
+
+aaf_expr aaf_sum(const aaf_expr * P, unsigned n) {
+    if (n == 0)
+        return aaf_expr(0.);
+    if (n == 1)
+        return P[0];
+    return aaf_sum(P, n/2) + aaf_sum(P + n/2, n - n/2);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,226 @@
+/*
+ * aa_program.h -- Recorded AAF programs and their parallel evaluation
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_PROGRAM_H
+#define AA_PROGRAM_H
+
+#include "aa_aaf.h"
+#include <map>
+#include <vector>
+
+class aa_program;
+
+
+typedef enum aa_program_op {
+    AA_PROG_INPUT,
+    AA_PROG_CONST,
+    AA_PROG_ADD,
+    AA_PROG_SUB,
+    AA_PROG_NEG,
+    AA_PROG_MUL,
+    AA_PROG_DIV,
+    AA_PROG_SQR,
+    AA_PROG_SQRT,
+    AA_PROG_INV,
+    AA_PROG_EXP,
+    AA_PROG_LOG,
+    AA_PROG_POWI,
+    AA_PROG_POW,
+    AA_PROG_ABS,
+    AA_PROG_SIN,
+    AA_PROG_COS,
+    AA_PROG_TAN,
+    AA_PROG_SINH,
+    AA_PROG_COSH,
+    AA_PROG_TANH,
+    AA_PROG_ASINH,
+    AA_PROG_ACOSH
+} aa_program_op;
+
+
+// A value of a recorded program (or a constant, on no program : the
+// operations on constants are done at once)
+// A function template written for AAF can be recorded on aaf_expr as
+// is, the operands of an operation must be on the same program
+
+class aaf_expr
+{
+
+private:
+    aa_program * prog;  // NULL for a constant
+    unsigned node;
+    AAF cst;
+
+    aaf_expr(aa_program * prog, unsigned node) : prog(prog), node(node) {}
+
+    friend class aa_program;
+
+public:
+
+    aaf_expr(double c = 0) : prog(NULL), node(0), cst(c) {}
+    aaf_expr(const AAF & c) : prog(NULL), node(0), cst(c) {}
+
+    bool is_constant() const {
+        return prog == NULL;
+    }
+    const AAF & constant() const {
+        return cst;
+    }
+};
+
+
+// The operations of a function y = f(x[0] ... x[n-1]), recorded once
+// and evaluated in AA on as many inputs as needed
+//
+// The operations which don't depend on each other are evaluated by
+// set_threads() threads : each thread runs the operations whose
+// operands are known from its own list, last in first out, and takes
+// the oldest ones of the lists of the others when its list is empty
+// Each operation gets a block of noise symbols above the ones of the
+// operations before it, so the indexes of the results stay sorted and
+// they are the same whatever the number of threads
+//
+//   aa_program p;
+//   aaf_expr x = p.input();
+//   aaf_expr y = p.input();
+//   p.output(x*exp(y) + 1.);
+//   p.set_threads(4);
+//   AAF in[2] = { AAF(interval(1, 2)), AAF(interval(0, 1)) };
+//   AAF out[1];
+//   p.evaluate(in, out);
+//
+// The long sums are better recorded with aaf_sum(), as balanced trees
+// whose levels are evaluated in parallel
+//
+// The program is a DAG : an operation already recorded on the same
+// operands isn't recorded again (so x*y is evaluated once however many
+// times it is written, with the same noise symbols) and the constants
+// are shared
+// Unless set_rewrite(false) is called before recording, the operations
+// are also rewritten into ones with fewer or tighter nonlinear steps :
+//   x*x is sqr(x), pow(x, n) is done by squarings (sharing sqr(x),
+//   sqr(sqr(x)), ... with the other powers of x, n being an int or a
+//   double of integer value), c*x*y is c*(x*y),
+//   cosh, sinh and tanh share exp(x) and exp(-x), tan shares sin(x) and
+//   cos(x), acosh shares sqr(x), and x + 0, x*1, x/1, -(-x), pow(x, 1)
+//   are x
+
+class aa_program
+{
+
+private:
+    struct node
+    {
+        aa_program_op op;
+        unsigned arg[2];
+        int n;          // exponent of AA_PROG_POWI, input index
+        double p;       // exponent of AA_PROG_POW
+
+        bool operator < (const node & k) const;
+    };
+
+    std::vector<node> nodes;
+    std::vector<AAF> constants;  // of the AA_PROG_CONST nodes (by n)
+    std::vector<unsigned> inputs;
+    std::vector<unsigned> outputs;
+    std::map<node, unsigned> recorded;      // the operations
+    std::map<uint64_t, unsigned> scalars;   // the constants of no noise symbol (by bits)
+    unsigned threads;
+    bool rewrite;
+
+    struct run;
+
+    aaf_expr push(const node & k);
+    aaf_expr record(node k);
+    bool simplify(const node & k, aaf_expr & e);
+    aaf_expr ref(unsigned k);
+    bool scalar(unsigned k, double & c) const;
+    unsigned place(const aaf_expr & e);
+    static unsigned symbols(const node & k);
+    static AAF apply(const node & k, const AAF & a, const AAF & b, bool ca, bool cb);
+    static void * work(void * arg);
+
+    aa_program(const aa_program &);
+    aa_program & operator = (const aa_program &);
+
+public:
+
+    aa_program() : threads(1), rewrite(true) {}
+
+    aaf_expr input();
+    unsigned output(const aaf_expr & f);
+    void clear();
+
+    unsigned get_inputs() const;
+    unsigned get_outputs() const;
+    unsigned size() const;
+
+    void set_threads(unsigned n);
+    void set_rewrite(bool on = true);
+
+    void evaluate(const AAF * x, AAF * y) const;
+
+    // Record an operation (the functions of the library are recorded
+    // with them), n and p being the exponents of pow
+
+    static aaf_expr unary(aa_program_op op, const aaf_expr & u, int n = 0, double p = 0);
+    static aaf_expr binary(aa_program_op op, const aaf_expr & a, const aaf_expr & b);
+};
+
+
+aaf_expr operator + (const aaf_expr & a, const aaf_expr & b);
+aaf_expr operator - (const aaf_expr & a, const aaf_expr & b);
+aaf_expr operator - (const aaf_expr & a);
+aaf_expr operator * (const aaf_expr & a, const aaf_expr & b);
+aaf_expr operator / (const aaf_expr & a, const aaf_expr & b);
+
+aaf_expr sqr(const aaf_expr & u);
+aaf_expr sqrt(const aaf_expr & u);
+aaf_expr inv(const aaf_expr & u);
+aaf_expr exp(const aaf_expr & u);
+aaf_expr log(const aaf_expr & u);
+aaf_expr pow(const aaf_expr & u, int n);
+aaf_expr pow(const aaf_expr & u, double p);
+aaf_expr abs(const aaf_expr & u);
+aaf_expr sin(const aaf_expr & u);
+aaf_expr cos(const aaf_expr & u);
+aaf_expr tan(const aaf_expr & u);
+aaf_expr sinh(const aaf_expr & u);
+aaf_expr cosh(const aaf_expr & u);
+aaf_expr tanh(const aaf_expr & u);
+aaf_expr asinh(const aaf_expr & u);
+aaf_expr acosh(const aaf_expr & u);
+
+aaf_expr aaf_sum(const aaf_expr * P, unsigned n);
+
+#endif  // AA_PROGRAM_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
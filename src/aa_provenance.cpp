@@ -0,0 +1,163 @@
+/*
+ * aa_provenance.cpp -- Origin of the noise symbols
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_provenance.h"
+#include "aa_util.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+bool aa_provenance_on = false;
+
+static const char * current_site = NULL;
+static std::vector<aa_origin> origins;  // indexed by the noise symbol
+
+
+void aa_provenance_enable(bool on) {
+    aa_provenance_on = on;
+}
+
+
+bool aa_provenance_enabled() {
+    return aa_provenance_on;
+}
+
+
+// Forget all the tags
+
+void aa_provenance_clear() {
+    std::vector<aa_origin>().swap(origins);
+    current_site = NULL;
+}
+
+
+// The call site of the next operations
+
+void aa_provenance_site(const char * site) {
+    current_site = site;
+}
+
+
+// Tag a new noise symbol
+// op NULL means the operation running
+
+void aa_provenance_tag(aa_symbol index, const char * op) {
+    if (!op)
+        op = (aa_current_op >= 0) ? aa_stats_name((aa_stat_op)aa_current_op) : "?";
+
+    if (index >= origins.size()) {
+        aa_origin none = { NULL, NULL };
+        origins.resize(index + 1, none);
+    }
+
+    origins[index].op = op;
+    origins[index].site = current_site;
+}
+
+
+// Origin of a noise symbol
+
+aa_origin aa_provenance_of(aa_symbol index) {
+    if (index < origins.size())
+        return origins[index];
+
+    aa_origin none = { NULL, NULL };
+    return none;
+}
+
+
+// The symbols used[0] ... used[k-1] become 1 ... k (see aaf_compact)
+
+void aa_provenance_renumber(const aa_symbol * used, unsigned k) {
+    if (origins.empty())
+        return;
+
+    aa_origin none = { NULL, NULL };
+    std::vector<aa_origin> moved(k + 1, none);
+    for (unsigned i = 0; i < k; i++)
+        moved[i + 1] = aa_provenance_of(used[i]);
+    origins.swap(moved);
+}
+
+
+// Order of the terms, the largest first
+
+static bool larger_term(const aa_term & a, const aa_term & b) {
+    return fabs(a.coeff) > fabs(b.coeff);
+}
+
+
+// The n largest terms of P (by |coefficient|), with their origin
+// Returns the number of terms written (at most n)
+
+unsigned aaf_rank_terms(const AAF & P, aa_term * terms, unsigned n) {
+    const unsigned l = P.get_length();
+    std::vector<aa_term> all(l);
+
+    for (unsigned i = 0; i < l; i++) {
+        all[i].index = P.get_index(i);
+        all[i].coeff = P.get_coeff(i);
+        all[i].origin = aa_provenance_of(all[i].index);
+    }
+
+    if (n > l)
+        n = l;
+    std::partial_sort(all.begin(), all.begin() + n, all.end(), larger_term);
+    std::copy(all.begin(), all.begin() + n, terms);
+
+    return n;
+}
+
+
+// Print the n largest terms of P with their share of the total deviation
+
+void aaf_attribution_report(std::ostream & s, const AAF & P, unsigned n) {
+    std::vector<aa_term> terms(n);
+    n = aaf_rank_terms(P, n ? &terms[0] : NULL, n);
+
+    const double r = P.rad();
+    s << "total deviation " << r << " in " << P.get_length() << " terms\n";
+
+    for (unsigned i = 0; i < n; i++) {
+        const aa_term & t = terms[i];
+        s << "e" << t.index << " " << t.coeff;
+        if (r > 0)
+            s << " " << 100*fabs(t.coeff)/r << "%";
+        s << " " << (t.origin.op ? t.origin.op : "untagged");
+        if (t.origin.site)
+            s << " " << t.origin.site;
+        s << "\n";
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,89 @@
+/*
+ * aa_provenance.h -- Origin of the noise symbols
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_PROVENANCE_H
+#define AA_PROVENANCE_H
+
+#include "aa_aaf.h"
+#include <iostream>
+
+
+// When the provenance mode is on, each new noise symbol is tagged with
+// the operation that made it ("sqrt", "*", ... or "input" for the
+// AAFs built from intervals) and with the current call site, a label
+// set by the application with aa_provenance_site() or AA_MARK()
+// The terms of a result can then be ranked by their magnitude to find
+// the operations that made it wide
+//
+//   aa_provenance_enable();
+//   AA_MARK();
+//   AAF y = sqrt(x) * inv(x + 1);
+//   aaf_attribution_report(std::cout, y);
+//
+// The tags are kept in a global table : this is a debugging mode,
+// for a single thread
+
+struct aa_origin
+{
+    const char * op;    // operation, NULL if the symbol is unknown
+    const char * site;  // call site, NULL if none was set
+};
+
+struct aa_term
+{
+    aa_symbol index;    // noise symbol
+    double coeff;
+    aa_origin origin;
+};
+
+void aa_provenance_enable(bool on = true);
+bool aa_provenance_enabled();
+void aa_provenance_clear();
+
+void aa_provenance_site(const char * site);
+void aa_provenance_tag(aa_symbol index, const char * op);
+aa_origin aa_provenance_of(aa_symbol index);
+void aa_provenance_renumber(const aa_symbol * used, unsigned k);
+
+unsigned aaf_rank_terms(const AAF & P, aa_term * terms, unsigned n);
+void aaf_attribution_report(std::ostream & s, const AAF & P, unsigned n = 10);
+
+// Set the call site to the current file and line
+// (the string must outlive the tags, a literal does)
+
+#define AA_STRINGIFY2(x) #x
+#define AA_STRINGIFY(x) AA_STRINGIFY2(x)
+#define AA_HERE __FILE__ ":" AA_STRINGIFY(__LINE__)
+#define AA_MARK() aa_provenance_site(AA_HERE)
+
+#endif  // AA_PROVENANCE_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,387 @@
+/*
+ * aa_quad.cpp -- Quadratic forms of noise symbols
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_quad.h"
+#include "aa_util.h"
+#include <algorithm>
+#include <cmath>
+
+
+unsigned aaf_quad::max_terms = AA_QUAD_MAX_TERMS;
+
+
+// Number of quadratic terms kept by the operations
+
+void aaf_quad::set_max_terms(unsigned n) {
+    max_terms = n;
+}
+
+unsigned aaf_quad::get_max_terms() {
+    return max_terms;
+}
+
+
+static bool term_before(const aa_quad_term & a, const aa_quad_term & b) {
+    return (a.i < b.i) || (a.i == b.i && a.j < b.j);
+}
+
+// What err gets when the term is dropped : c*e_i^2 is c/2 + [-c/2,c/2]
+
+static double term_cost(const aa_quad_term & t) {
+    return (t.i == t.j) ? fabs(t.c)/2 : fabs(t.c);
+}
+
+static bool term_larger(const aa_quad_term & a, const aa_quad_term & b) {
+    return term_cost(a) > term_cost(b);
+}
+
+
+// Sort the terms of q and add the ones of the same e_i*e_j
+
+static void combine(std::vector<aa_quad_term> & q, aa_roundoff & ro) {
+    std::sort(q.begin(), q.end(), term_before);
+
+    unsigned n = 0;
+    for (unsigned k = 0; k < q.size(); k++) {
+        if (n && q[n-1].i == q[k].i && q[n-1].j == q[k].j)
+            q[n-1].c = ro.add(q[n-1].c, q[k].c);
+        else
+            q[n++] = q[k];
+    }
+    q.resize(n);
+}
+
+
+// The term c*e_s*e_t
+
+static void push_term(std::vector<aa_quad_term> & q, aa_symbol s, aa_symbol t, double c) {
+    aa_quad_term term;
+    term.i = std::min(s, t);
+    term.j = std::max(s, t);
+    term.c = c;
+    q.push_back(term);
+}
+
+
+// Keep the max_terms largest quadratic terms, the others go to
+// delta (and the centers of their squares to the center of lin)
+
+void aaf_quad::trim(aa_roundoff & ro, double & delta) {
+    if (quad.size() <= max_terms)
+        return;
+
+    std::nth_element(quad.begin(), quad.begin() + max_terms, quad.end(), term_larger);
+
+    double shift = 0;
+    for (unsigned k = max_terms; k < quad.size(); k++) {
+        if (quad[k].i == quad[k].j)
+            shift = ro.add(shift, quad[k].c/2);
+        delta += term_cost(quad[k]);
+    }
+
+    quad.resize(max_terms);
+    std::sort(quad.begin(), quad.end(), term_before);
+
+    if (shift != 0)
+        lin = lin + AAF(shift);
+}
+
+
+// Sum of the |b_ij|
+
+double aaf_quad::quad_mag() const {
+    double m = 0;
+    for (unsigned k = 0; k < quad.size(); k++)
+        m += fabs(quad[k].c);
+    return m;
+}
+
+
+bool aaf_quad::is_constant() const {
+    return !lin.get_length() && quad.empty() && err == 0 && !lin.is_indeterminate();
+}
+
+
+// An AAF holding x, the quadratic terms and err are put in a new
+// noise symbol
+
+AAF aaf_quad::to_aaf() const {
+    if (quad.empty() && err == 0)
+        return lin;
+
+    aa_roundoff ro;
+    double shift = 0;
+    double delta = err;
+    for (unsigned k = 0; k < quad.size(); k++) {
+        if (quad[k].i == quad[k].j)
+            shift = ro.add(shift, quad[k].c/2);
+        delta += term_cost(quad[k]);
+    }
+    delta = ro.error(delta, quad.size() + 1);
+
+    AAF r = lin;
+    if (shift != 0)
+        r = r + AAF(shift);
+    if (delta > 0)
+        r = r + AAF(interval(-delta, delta));
+    return r;
+}
+
+
+// Range of x : e_i*e_j is in [-1,1] and e_i^2 in [0,1]
+
+interval aaf_quad::convert() const {
+    interval q(0.);
+    for (unsigned k = 0; k < quad.size(); k++) {
+        const double c = quad[k].c;
+        if (quad[k].i == quad[k].j)
+            q = q + interval(std::min(0., c), std::max(0., c));
+        else
+            q = q + interval(-fabs(c), fabs(c));
+    }
+
+    return lin.convert() + q + interval(-err, err);
+}
+
+
+aaf_quad operator + (const aaf_quad & x, const aaf_quad & y) {
+    aa_roundoff ro;
+    aaf_quad r(x.lin + y.lin);
+
+    r.quad = x.quad;
+    r.quad.insert(r.quad.end(), y.quad.begin(), y.quad.end());
+    combine(r.quad, ro);
+
+    double delta = x.err + y.err;
+    r.trim(ro, delta);
+    r.err = ro.error(delta, y.quad.size() + 2);
+    return r;
+}
+
+
+aaf_quad operator - (const aaf_quad & x) {
+    aaf_quad r(-x.lin);
+    r.quad = x.quad;
+    for (unsigned k = 0; k < r.quad.size(); k++)
+        r.quad[k].c = -r.quad[k].c;
+    r.err = x.err;
+    return r;
+}
+
+
+aaf_quad operator - (const aaf_quad & x, const aaf_quad & y) {
+    return x + (-y);
+}
+
+
+aaf_quad operator * (const aaf_quad & x, double c) {
+    if (c == 0)
+        return aaf_quad(x.lin*c);
+
+    aa_roundoff ro;
+    aaf_quad r(x.lin*c);
+
+    r.quad = x.quad;
+    for (unsigned k = 0; k < r.quad.size(); k++)
+        r.quad[k].c = ro.mul(c, r.quad[k].c);
+
+    r.err = ro.error(x.err*fabs(c), 1);
+    return r;
+}
+
+aaf_quad operator * (double c, const aaf_quad & x) {
+    return x*c;
+}
+
+
+// x0*y0 + x0*B + y0*A for x = x0 + A and y = y0 + B, in a single merge
+
+AAF aaf_quad::affine_product(const AAF & x, const AAF & y, double x0y0) {
+    const AAF * f[2] = { &x, &y };
+    const double scale[2] = { y.cvalue, x.cvalue };
+    return AAF::merge(2, f, scale, x0y0, AAF_TYPE_AFFINE, false, 0);
+}
+
+
+// The largest terms of P in s and a, the sum of their |a| in top and
+// of the others in rest
+
+static void top_terms(const AAF & P, unsigned m, std::vector<aa_symbol> & s,
+                      std::vector<double> & a, double & top, double & rest)
+{
+    const unsigned l = P.get_length();
+    top = rest = 0;
+
+    if (l <= m) {
+        for (unsigned k = 0; k < l; k++) {
+            s.push_back(P.get_index(k));
+            a.push_back(P.get_coeff(k));
+            top += fabs(a[k]);
+        }
+        return;
+    }
+
+    std::vector<std::pair<double, unsigned> > order(l);
+    for (unsigned k = 0; k < l; k++)
+        order[k] = std::make_pair(-fabs(P.get_coeff(k)), k);
+    std::partial_sort(order.begin(), order.begin() + m, order.end());
+
+    for (unsigned k = 0; k < l; k++) {
+        if (k < m) {
+            s.push_back(P.get_index(order[k].second));
+            a.push_back(P.get_coeff(order[k].second));
+            top -= order[k].first;
+        } else {
+            rest -= order[k].first;
+        }
+    }
+}
+
+
+// (x0 + A + Q1 + r1)*(y0 + B + Q2 + r2) where A and B are the sums of
+// the a_i*e_i and of the b_j*e_j, Q1 and Q2 the quadratic parts :
+// x0*y0 + x0*B + y0*A is the affine part, x0*Q2 + y0*Q1 + A*B the
+// quadratic part (the products of the m largest a_i and b_j only)
+// and the rest is bounded in err
+
+aaf_quad operator * (const aaf_quad & x, const aaf_quad & y) {
+    if (y.is_constant())
+        return x*y.lin.get_center();
+    if (x.is_constant())
+        return y*x.lin.get_center();
+    if (x.lin.is_indeterminate() || y.lin.is_indeterminate())
+        return aaf_quad(x.lin*y.lin);
+
+    aa_roundoff ro;
+    const double x0 = x.lin.get_center();
+    const double y0 = y.lin.get_center();
+
+    aaf_quad r(aaf_quad::affine_product(x.lin, y.lin, ro.mul(x0, y0)));
+
+    // A*B from the largest terms, with at most 2*max_terms products
+
+    unsigned m = 1;
+    while ((m + 1)*(m + 1) <= 2*aaf_quad::max_terms)
+        m++;
+
+    std::vector<aa_symbol> s, t;
+    std::vector<double> a, b;
+    s.reserve(m);
+    t.reserve(m);
+    a.reserve(m);
+    b.reserve(m);
+    double ta, ra, tb, rb;
+    top_terms(x.lin, m, s, a, ta, ra);
+    top_terms(y.lin, m, t, b, tb, rb);
+
+    r.quad.reserve(s.size()*t.size() + x.quad.size() + y.quad.size());
+    for (unsigned p = 0; p < s.size(); p++)
+        for (unsigned q = 0; q < t.size(); q++)
+            push_term(r.quad, s[p], t[q], ro.mul(a[p], b[q]));
+
+    for (unsigned k = 0; k < x.quad.size(); k++)
+        push_term(r.quad, x.quad[k].i, x.quad[k].j, ro.mul(y0, x.quad[k].c));
+    for (unsigned k = 0; k < y.quad.size(); k++)
+        push_term(r.quad, y.quad[k].i, y.quad[k].j, ro.mul(x0, y.quad[k].c));
+
+    combine(r.quad, ro);
+
+    // the products of A*B left out, the terms of degree 3 and 4
+    // and the products by err
+
+    const double q1 = x.quad_mag();
+    const double q2 = y.quad_mag();
+    const double ma = ta + ra, mb = tb + rb;
+
+    double delta = ra*mb + ta*rb + ma*q2 + q1*mb + q1*q2;
+    if (x.err > 0 || y.err > 0)
+        delta += x.err*(fabs(y0) + mb + q2) + y.err*(fabs(x0) + ma + q1) + x.err*y.err;
+
+    r.trim(ro, delta);
+    r.err = ro.error(delta, x.lin.get_length() + y.lin.get_length() +
+                     x.quad.size() + y.quad.size() + 16);
+    return r;
+}
+
+
+aaf_quad operator / (const aaf_quad & x, const aaf_quad & y) {
+    return x*inv(y);
+}
+
+
+aaf_quad sqr(const aaf_quad & x) {
+    return x*x;
+}
+
+
+aaf_quad pow(const aaf_quad & x, int n) {
+    if (n == 0)
+        return aaf_quad(1.);
+    if (n < 0)
+        return inv(pow(x, -n));
+
+    const aaf_quad h = pow(x, n/2);
+    return (n & 1) ? h*h*x : h*h;
+}
+
+
+// The non polynomial functions, in AA
+
+aaf_quad sqrt(const aaf_quad & x) {
+    return aaf_quad(sqrt(x.to_aaf()));
+}
+
+aaf_quad inv(const aaf_quad & x) {
+    return aaf_quad(inv(x.to_aaf()));
+}
+
+aaf_quad exp(const aaf_quad & x) {
+    return aaf_quad(exp(x.to_aaf()));
+}
+
+aaf_quad log(const aaf_quad & x) {
+    return aaf_quad(log(x.to_aaf()));
+}
+
+aaf_quad sin(const aaf_quad & x) {
+    return aaf_quad(sin(x.to_aaf()));
+}
+
+aaf_quad cos(const aaf_quad & x) {
+    return aaf_quad(cos(x.to_aaf()));
+}
+
+aaf_quad abs(const aaf_quad & x) {
+    return aaf_quad(abs(x.to_aaf()));
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
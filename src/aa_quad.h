@@ -0,0 +1,138 @@
+/*
+ * aa_quad.h -- Quadratic forms of noise symbols
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_QUAD_H
+#define AA_QUAD_H
+
+#include "aa_aaf.h"
+#include "aa_interval.h"
+#include <vector>
+
+#define AA_QUAD_MAX_TERMS 32
+
+
+// The term c*e_i*e_j of a quadratic form (i <= j)
+
+struct aa_quad_term
+{
+    aa_symbol i, j;
+    double c;
+};
+
+
+// Quadratic form
+//
+//   x = x0 + sum a_i*e_i + sum b_ij*e_i*e_j + err*[-1,1]
+//
+// the affine part being an AAF : the products keep the terms e_i*e_j
+// of the product of the affine parts, where AA puts rad(x)*rad(y) in a
+// new noise symbol, so x*x - x or (x - y)*(x + y) keep their
+// correlations
+// Only the largest set_max_terms() quadratic terms are kept, the
+// others (and the terms of degree 3 and 4 of the products) go to err
+//
+// The other functions (sqrt, exp, ...) are done in AA on to_aaf(),
+// which puts the quadratic terms and err in a new noise symbol
+//
+//   AAF x(interval(0, 1));
+//   aaf_quad y = aaf_quad(x)*x - x + 0.5;
+//   y.convert()                   // [0.25, 0.5], AA finds [0, 0.5]
+
+class aaf_quad
+{
+
+private:
+    AAF lin;                          // affine part
+    std::vector<aa_quad_term> quad;   // sorted by (i,j)
+    double err;
+
+    static unsigned max_terms;
+
+    void trim(aa_roundoff & ro, double & delta);
+    static AAF affine_product(const AAF & x, const AAF & y, double x0y0);
+    double quad_mag() const;
+    bool is_constant() const;
+
+public:
+
+    aaf_quad(double c = 0) : lin(c), err(0) {}
+    aaf_quad(const AAF & x) : lin(x), err(0) {}
+
+    static void set_max_terms(unsigned n = AA_QUAD_MAX_TERMS);
+    static unsigned get_max_terms();
+
+    const AAF & get_linear() const {
+        return lin;
+    }
+    unsigned get_terms() const {
+        return quad.size();
+    }
+    const aa_quad_term & get_term(unsigned k) const {
+        return quad[k];
+    }
+    double get_error() const {
+        return err;
+    }
+
+    AAF to_aaf() const;
+    interval convert() const;
+
+    friend aaf_quad operator + (const aaf_quad & x, const aaf_quad & y);
+    friend aaf_quad operator - (const aaf_quad & x, const aaf_quad & y);
+    friend aaf_quad operator - (const aaf_quad & x);
+    friend aaf_quad operator * (const aaf_quad & x, const aaf_quad & y);
+    friend aaf_quad operator * (const aaf_quad & x, double c);
+};
+
+aaf_quad operator + (const aaf_quad & x, const aaf_quad & y);
+aaf_quad operator - (const aaf_quad & x, const aaf_quad & y);
+aaf_quad operator - (const aaf_quad & x);
+aaf_quad operator * (const aaf_quad & x, const aaf_quad & y);
+aaf_quad operator * (const aaf_quad & x, double c);
+aaf_quad operator * (double c, const aaf_quad & x);
+aaf_quad operator / (const aaf_quad & x, const aaf_quad & y);
+
+aaf_quad sqr(const aaf_quad & x);
+aaf_quad pow(const aaf_quad & x, int n);
+
+// in AA
+
+aaf_quad sqrt(const aaf_quad & x);
+aaf_quad inv(const aaf_quad & x);
+aaf_quad exp(const aaf_quad & x);
+aaf_quad log(const aaf_quad & x);
+aaf_quad sin(const aaf_quad & x);
+aaf_quad cos(const aaf_quad & x);
+aaf_quad abs(const aaf_quad & x);
+
+#endif  // AA_QUAD_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
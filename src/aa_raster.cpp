@@ -0,0 +1,285 @@
+/*
+ * aa_raster.cpp -- Subdivision of the cells of implicit curves and surfaces
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_raster.h"
+#include <algorithm>
+#include <cmath>
+#include "aa_rounding.h"
+#include <pthread.h>
+
+
+// What to do with a cell
+
+enum {
+    AA_VISIT_DROP,
+    AA_VISIT_REPORT,
+    AA_VISIT_SPLIT
+};
+
+
+// The child k of the cell c (the bit i of k says which half along
+// the axis i), in d
+
+static void child(const aa_cell & c, unsigned dim, unsigned k, aa_cell & d) {
+    for (unsigned i = 0; i < dim; i++) {
+        const double mid = 0.5*(c.lo[i] + c.hi[i]);
+        d.lo[i] = (k & (1 << i)) ? mid : c.lo[i];
+        d.hi[i] = (k & (1 << i)) ? c.hi[i] : mid;
+    }
+    d.depth = c.depth + 1;
+}
+
+
+// Create the subdivision of [0,1]^dim along f = 0
+
+aa_raster::aa_raster(unsigned dim, aa_implicit f, void * data)
+    : dim(std::min(dim, (unsigned)AA_RASTER_MAX_DIM)), f(f), data(data), max_depth(8),
+      flat(0), inside(false), threads(1)
+{
+    for (unsigned i = 0; i < AA_RASTER_MAX_DIM; i++) {
+        lo[i] = 0;
+        hi[i] = 1;
+    }
+}
+
+
+// The box to subdivide
+
+void aa_raster::set_domain(const double * l, const double * h) {
+    for (unsigned i = 0; i < dim; i++) {
+        lo[i] = l[i];
+        hi[i] = h[i];
+    }
+}
+
+
+// The cells of the finest level are 2^max_depth times smaller
+// than the domain
+
+void aa_raster::set_depth(unsigned d) {
+    max_depth = d;
+}
+
+
+// Accept a cell when the non linear part of f is below ratio times
+// the affine part (0 to always go down to the finest level)
+
+void aa_raster::set_flatness(double ratio) {
+    flat = ratio;
+}
+
+
+// Also report the cells where f is negative
+
+void aa_raster::set_inside(bool on) {
+    inside = on;
+}
+
+
+// Number of threads
+
+void aa_raster::set_threads(unsigned n) {
+    threads = n ? n : 1;
+}
+
+
+// Evaluate f on the cell c and say what to do with it
+// (the type of c is set when it's reported)
+
+int aa_raster::visit(aa_cell & c) const {
+    AAF x[AA_RASTER_MAX_DIM];
+    aa_symbol sym[AA_RASTER_MAX_DIM];
+
+    for (unsigned i = 0; i < dim; i++) {
+        x[i] = AAF(interval(c.lo[i], c.hi[i]));
+        sym[i] = x[i].get_length() ? x[i].get_index(0) : 0;
+    }
+
+    const AAF v = f(x, data);
+
+    if (!v.is_indeterminate()) {
+        if (!v.straddles_zero()) {
+            if (!inside || !v.strictly_neg())
+                return AA_VISIT_DROP;
+            c.type = AA_CELL_INSIDE;
+            return AA_VISIT_REPORT;
+        }
+
+        // v = v0 + a.e + r where e are the symbols of x : f = 0 is
+        // in the slab |v0 + a.e| <= r, which is thin when r << |a|
+
+        if (flat > 0) {
+            double norm = 0, lin = 0;
+            for (unsigned i = 0; i < dim; i++) {
+                const double a = sym[i] ? v.index_coeff(sym[i]) : 0;
+                lin += fabs(a);
+                norm += a*a;
+            }
+
+            if (v.rad() - lin <= flat*sqrt(norm)) {
+                c.type = AA_CELL_FLAT;
+                return AA_VISIT_REPORT;
+            }
+        }
+    }
+
+    if (c.depth >= max_depth) {
+        c.type = AA_CELL_BOUNDARY;
+        return AA_VISIT_REPORT;
+    }
+
+    return AA_VISIT_SPLIT;
+}
+
+
+// Subdivide c (depth first) into out
+
+void aa_raster::descend(const aa_cell & c, std::vector<aa_cell> & out) const {
+    aa_cell d = c;
+
+    switch (visit(d)) {
+    case AA_VISIT_DROP:
+        return;
+    case AA_VISIT_REPORT:
+        out.push_back(d);
+        return;
+    }
+
+    for (unsigned k = 0; k < (1u << dim); k++) {
+        child(c, dim, k, d);
+        descend(d, out);
+    }
+}
+
+
+// The cells left to the threads
+
+struct aa_raster_work
+{
+    const aa_raster * r;
+    const std::vector<aa_cell> * todo;
+    std::vector<aa_cell> * out;  // one list per cell of todo
+    unsigned next;
+    bool up;                     // run() is in an aa_rounding_scope
+};
+
+void * aa_raster::work(void * arg) {
+    aa_raster_work * w = (aa_raster_work *)arg;
+
+    if (w->up && !aa_rounding_scope::active()) {
+        aa_rounding_scope scope;
+        return work(arg);
+    }
+
+    while (true) {
+        const unsigned k = __sync_fetch_and_add(&w->next, 1);
+        if (k >= w->todo->size())
+            break;
+        w->r->descend((*w->todo)[k], w->out[k]);
+    }
+
+    return NULL;
+}
+
+
+// Order of the cells in the result
+
+static bool cell_before(const aa_cell & a, const aa_cell & b) {
+    for (unsigned i = AA_RASTER_MAX_DIM; i-- > 0; ) {
+        if (a.lo[i] != b.lo[i])
+            return a.lo[i] < b.lo[i];
+    }
+    return a.depth < b.depth;
+}
+
+
+// Subdivide the domain, the cells reported are put in cells
+
+void aa_raster::run(std::vector<aa_cell> & cells) const {
+    cells.clear();
+
+    aa_cell root;
+    for (unsigned i = 0; i < AA_RASTER_MAX_DIM; i++) {
+        root.lo[i] = (i < dim) ? lo[i] : 0;
+        root.hi[i] = (i < dim) ? hi[i] : 0;
+    }
+    root.depth = 0;
+    root.type = AA_CELL_BOUNDARY;
+
+    // The first levels are done here, breadth first, until there
+    // are enough cells to keep the threads busy
+
+    std::vector<aa_cell> todo(1, root);
+    std::vector<aa_cell> split;
+
+    while ((threads > 1) && !todo.empty() && (todo.size() < 8*threads)) {
+        split.clear();
+        for (unsigned j = 0; j < todo.size(); j++) {
+            aa_cell d = todo[j];
+            switch (visit(d)) {
+            case AA_VISIT_DROP:
+                continue;
+            case AA_VISIT_REPORT:
+                cells.push_back(d);
+                continue;
+            }
+
+            for (unsigned k = 0; k < (1u << dim); k++) {
+                child(todo[j], dim, k, d);
+                split.push_back(d);
+            }
+        }
+        todo.swap(split);
+    }
+
+    std::vector<std::vector<aa_cell> > out(todo.size());
+    aa_raster_work w = { this, &todo, out.empty() ? NULL : &out[0], 0,
+                         aa_rounding_scope::active() };
+
+    // (this thread is one of them)
+
+    const unsigned n = std::min(threads, (unsigned)todo.size());
+    std::vector<pthread_t> id(n);
+    unsigned started = 0;
+    for (unsigned t = 1; t < n; t++)
+        if (!pthread_create(&id[started], NULL, work, &w))
+            started++;
+    work(&w);
+    for (unsigned t = 0; t < started; t++)
+        pthread_join(id[t], NULL);
+
+    for (unsigned k = 0; k < out.size(); k++)
+        cells.insert(cells.end(), out[k].begin(), out[k].end());
+    std::sort(cells.begin(), cells.end(), cell_before);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,109 @@
+/*
+ * aa_raster.h -- Subdivision of the cells of implicit curves and surfaces
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_RASTER_H
+#define AA_RASTER_H
+
+#include "aa_aaf.h"
+#include <vector>
+
+#define AA_RASTER_MAX_DIM 3
+
+
+// The function f(x) of the curve f(x,y) = 0 or of the surface
+// f(x,y,z) = 0 : x has 2 or 3 components
+// A template written for the doubles and the AAFs can be used as is,
+// e.g. &fct<AAF> with  template <class T> T fct(const T * x, void *)
+
+typedef AAF (*aa_implicit)(const AAF * x, void * data);
+
+typedef enum aa_cell_type {
+    AA_CELL_BOUNDARY,  // may hold a part of f = 0, at the finest level
+    AA_CELL_FLAT,      // holds a nearly planar part of f = 0 (see set_flatness)
+    AA_CELL_INSIDE     // f < 0 on the whole cell (see set_inside)
+} aa_cell_type;
+
+struct aa_cell
+{
+    double lo[AA_RASTER_MAX_DIM];
+    double hi[AA_RASTER_MAX_DIM];
+    unsigned depth;     // 0 for the whole domain
+    aa_cell_type type;
+};
+
+
+// Quadtree (2D) or octree (3D) subdivision of a domain along f = 0
+//
+// f is evaluated in AA on each cell : the cell is dropped when f
+// doesn't straddle zero, and split in 2^dim cells otherwise, until the
+// maximal depth where it is reported as a boundary cell
+// With set_flatness(ratio) a cell is reported as soon as the affine
+// part of f (its coefficients on the noise symbols of x) is large
+// enough that f = 0 is a plane up to ratio of the size of the cell
+//
+// The cells are processed by set_threads() threads, and they are
+// sorted (by their lower corner) so the result doesn't depend on it
+
+class aa_raster
+{
+
+private:
+    unsigned dim;
+    aa_implicit f;
+    void * data;
+
+    double lo[AA_RASTER_MAX_DIM];  // domain
+    double hi[AA_RASTER_MAX_DIM];
+    unsigned max_depth;
+    double flat;        // 0 if the cells are never accepted early
+    bool inside;        // report the cells where f < 0
+    unsigned threads;
+
+    int visit(aa_cell & c) const;
+    void descend(const aa_cell & c, std::vector<aa_cell> & out) const;
+    static void * work(void * arg);
+
+public:
+
+    aa_raster(unsigned dim, aa_implicit f, void * data = NULL);
+
+    void set_domain(const double * lo, const double * hi);
+    void set_depth(unsigned max_depth);
+    void set_flatness(double ratio);
+    void set_inside(bool on = true);
+    void set_threads(unsigned n);
+
+    void run(std::vector<aa_cell> & cells) const;
+};
+
+#endif  // AA_RASTER_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
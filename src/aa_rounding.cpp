@@ -22,6 +22,11 @@
 
 #include "aa_rounding.h"
 
+// Number of aa_rounding_scope alive
+
+__thread unsigned aa_rounding_scope::depth = 0;
+
+
 // Change the rounding mode
 
 unsigned int aa_fesetround(aa_rnd_t mask) {
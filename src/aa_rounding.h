@@ -45,6 +45,127 @@ typedef unsigned int aa_rnd_t;
 unsigned int aa_fesetround(aa_rnd_t);
 aa_rnd_t aa_fegetround(void);
 
+
+// Outward rounding without changing the rounding mode
+// If x is the result of an operation within one ulp of the exact
+// value (e.g. a correctly rounded one, whatever the rounding mode)
+// aa_round_up(x) >= exact value and aa_round_down(x) <= exact value
+
+#include <cfloat>
+#include <cmath>
+
+#define AA_MIN_DENORM (DBL_MIN*DBL_EPSILON) // smallest positive double
+
+inline double aa_round_up(double x) {
+    if (x == -HUGE_VAL)
+        return x;
+    return x + (fabs(x)*DBL_EPSILON + AA_MIN_DENORM);
+}
+
+inline double aa_round_down(double x) {
+    if (x == HUGE_VAL)
+        return x;
+    return x - (fabs(x)*DBL_EPSILON + AA_MIN_DENORM);
+}
+
+
+// Upward rounding for a whole evaluation
+// While an aa_rounding_scope lives the rounding mode is upward and the
+// AAF operations are rigorous : the round-off error of each affine
+// step is bounded and added to the error noise symbol, and the lines
+// of sqrt, inv, exp, log and pow (and of the functions built on them,
+// e.g. /, cosh or acosh) are bounded with outward rounded values of
+// the function
+// sin, cos, tan and cotan are not : the error of their line is the
+// largest one at a few points
+// The previous mode is restored when the scope ends
+// A scope only holds for the thread which opened it (the threads of
+// aa_raster and aa_program open their own when the caller is in one)
+//
+//   {
+//       aa_rounding_scope up;
+//       AAF z = x*y + 3*x;   // z encloses the exact result
+//       AAF w = exp(z)/z;    // so does w
+//   }
+
+class aa_rounding_scope
+{
+private:
+    static __thread unsigned depth;  // (the rounding mode is per thread)
+    aa_rnd_t saved;
+
+    aa_rounding_scope(const aa_rounding_scope &);
+    aa_rounding_scope & operator = (const aa_rounding_scope &);
+
+public:
+    aa_rounding_scope() : saved(aa_fegetround()) {
+        aa_fesetround(AA_UPWARD);
+        depth++;
+    }
+
+    ~aa_rounding_scope() {
+        depth--;
+        aa_fesetround(saved);
+    }
+
+    static bool active() {
+        return depth != 0;
+    }
+};
+
+
+// Sum and product rounded up (in an aa_rounding_scope)
+// err is increased by the distance between the results rounded up
+// and rounded down, the latter being -((-a)-b) and -((-a)*b)
+// The library is built with -frounding-math so that the compiler
+// doesn't simplify these
+
+inline double aa_add_up(double a, double b, double & err) {
+    const double s = a + b;
+    const double e = s + ((-a) - b);
+    if (e < HUGE_VAL) // not on overflow
+        err += e;
+    return s;
+}
+
+inline double aa_mul_up(double a, double b, double & err) {
+    const double p = a*b;
+    const double e = p + ((-a)*b);
+    if (e < HUGE_VAL)
+        err += e;
+    return p;
+}
+
+
+// Error free transformations (in round to nearest)
+// a+b == s+e and a*b == p+e exactly, barring overflow
+// (and underflow for the product)
+
+inline double aa_two_sum(double a, double b, double & e) {
+    const double s = a + b;
+    const double bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+inline double aa_two_prod(double a, double b, double & e) {
+    const double p = a*b;
+#ifdef FP_FAST_FMA
+    e = fma(a, b, -p);
+#else
+    // Dekker's product, the operands are split in 26 bit halves
+
+    const double ca = 134217729.0*a; // 2^27+1
+    const double ah = ca - (ca - a);
+    const double al = a - ah;
+    const double cb = 134217729.0*b;
+    const double bh = cb - (cb - b);
+    const double bl = b - bh;
+    e = ((ah*bh - p) + ah*bl + al*bh) + al*bl;
+#endif
+    return p;
+}
+
 #endif
 /*
   Local Variables:
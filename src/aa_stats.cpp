@@ -0,0 +1,137 @@
+/*
+ * aa_stats.cpp -- Counters of the AAF operations
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_stats.h"
+#include "aa_util.h"
+#include <cstring>
+
+
+__thread int aa_current_op = -1;
+
+#ifdef AA_STATS
+__thread aa_stats aa_stats_local;
+#endif
+
+static const char * const names[AA_OP_COUNT] = {
+    "+", "-", "neg", "shift", "scale", "*", "/",
+    "sum", "dot",
+    "sqrt", "inv", "abs", "sqr", "pow_int", "pow",
+    "exp", "log",
+    "sin", "cos", "tan", "cotan",
+    "cosh", "sinh", "tanh", "acosh", "asinh", "atanh"
+};
+
+
+// Says if the library counts anything
+
+bool aa_stats_enabled() {
+#ifdef AA_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+// A copy of the counters of this thread
+
+aa_stats aa_stats_snapshot() {
+#ifdef AA_STATS
+    return aa_stats_local;
+#else
+    aa_stats st;
+    memset(&st, 0, sizeof(st));
+    return st;
+#endif
+}
+
+
+// Set the counters of this thread to 0
+
+void aa_stats_reset() {
+#ifdef AA_STATS
+    memset(&aa_stats_local, 0, sizeof(aa_stats_local));
+#endif
+}
+
+
+// Add the counters of from to to
+// (e.g. to sum the snapshots of all threads)
+
+void aa_stats_add(aa_stats & to, const aa_stats & from) {
+    for (unsigned i = 0; i < AA_OP_COUNT; i++) {
+        to.calls[i] += from.calls[i];
+        if (from.max_error[i] > to.max_error[i])
+            to.max_error[i] = from.max_error[i];
+    }
+    to.forms += from.forms;
+    to.total_length += from.total_length;
+    for (unsigned k = 0; k < AA_STATS_BUCKETS; k++)
+        to.lengths[k] += from.lengths[k];
+    to.symbols += from.symbols;
+    to.allocations += from.allocations;
+}
+
+
+// Name of an operation
+
+const char * aa_stats_name(aa_stat_op op) {
+    if ((unsigned)op >= AA_OP_COUNT)
+        return "?";
+    return names[op];
+}
+
+
+// Print the counters, one "name value" per line
+// so that it's easy to feed to other tools
+
+void aa_stats_report(std::ostream & s, const aa_stats & st) {
+    s << "forms " << st.forms << "\n";
+    s << "mean_length "
+      << (st.forms ? (double)st.total_length/st.forms : 0.) << "\n";
+    s << "symbols " << st.symbols << "\n";
+    s << "allocations " << st.allocations << "\n";
+
+    for (unsigned k = 0; k < AA_STATS_BUCKETS; k++)
+        if (st.lengths[k])
+            s << "length_" << (k ? 1u << (k-1) : 0) << " " << st.lengths[k] << "\n";
+
+    for (unsigned i = 0; i < AA_OP_COUNT; i++) {
+        if (!st.calls[i])
+            continue;
+        s << "calls_" << names[i] << " " << st.calls[i] << "\n";
+        if (st.max_error[i] > 0)
+            s << "max_error_" << names[i] << " " << st.max_error[i] << "\n";
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
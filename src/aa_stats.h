@@ -0,0 +1,80 @@
+/*
+ * aa_stats.h -- Counters of the AAF operations
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_STATS_H
+#define AA_STATS_H
+
+#include <iostream>
+
+
+// The counters are only updated when the library is built with
+// AA_STATS (./configure CPPFLAGS=-DAA_STATS), otherwise they cost
+// nothing and stay at 0
+// Each thread has its own counters
+
+typedef enum aa_stat_op {
+    AA_OP_ADD, AA_OP_SUB, AA_OP_NEG, AA_OP_SHIFT, AA_OP_SCALE, AA_OP_MUL, AA_OP_DIV,
+    AA_OP_SUM, AA_OP_DOT,
+    AA_OP_SQRT, AA_OP_INV, AA_OP_ABS, AA_OP_SQR, AA_OP_POW_INT, AA_OP_POW,
+    AA_OP_EXP, AA_OP_LOG,
+    AA_OP_SIN, AA_OP_COS, AA_OP_TAN, AA_OP_COTAN,
+    AA_OP_COSH, AA_OP_SINH, AA_OP_TANH, AA_OP_ACOSH, AA_OP_ASINH, AA_OP_ATANH,
+    AA_OP_COUNT
+} aa_stat_op;
+
+// Bucket k of the length histogram counts the lengths in [2^(k-1),2^k)
+// (bucket 0 is the length 0, the last one also has all longer forms)
+
+#define AA_STATS_BUCKETS 16
+
+struct aa_stats
+{
+    unsigned long calls[AA_OP_COUNT];  // calls of each operation
+    double max_error[AA_OP_COUNT];     // widest error symbol it made
+    unsigned long forms;               // AAFs built by the operations
+    unsigned long total_length;        // sum of their lengths
+    unsigned long lengths[AA_STATS_BUCKETS];
+    unsigned long symbols;             // noise symbols created
+    unsigned long allocations;         // new[] calls
+};
+
+bool aa_stats_enabled();
+
+aa_stats aa_stats_snapshot();
+void aa_stats_reset();
+void aa_stats_add(aa_stats & to, const aa_stats & from);
+
+const char * aa_stats_name(aa_stat_op op);
+void aa_stats_report(std::ostream & s, const aa_stats & st);
+
+#endif  // AA_STATS_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
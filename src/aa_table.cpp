@@ -0,0 +1,187 @@
+/*
+ * aa_table.cpp -- Table driven elementary functions
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_table.h"
+#include <cfloat>
+#include <cmath>
+
+
+// The argument is split as x = xj + r where xj is on a grid of step
+// 1/AA_TABLE_STEPS (so xj and r are exact) and f(xj) is in a table
+// f(r) is then a short polynomial as |r| < 1/AA_TABLE_STEPS
+
+#define AA_TABLE_STEPS 256
+
+#define AA_EXP_MIN (-708)
+#define AA_EXP_MAX 709
+#define AA_TRIGO_MAX 1048576.0 // 2^20, keeps k*TWO_PI_1 exact
+#define AA_TRIGO_STEPS 1610    // > 2*PI*AA_TABLE_STEPS
+
+// Error of the tables entries and of the few operations made
+// on them, in ulps (libm is assumed to be within 1 ulp)
+
+#define AA_TABLE_ERR (8*DBL_EPSILON)
+
+// 2*PI in 3 parts (Cody & Waite)
+// The first two ones have 33 significant bits
+
+#define TWO_PI_1 6.2831853069365025
+#define TWO_PI_2 2.4308402025215864e-10
+#define TWO_PI_3 8.089064995183803e-21
+
+#define LN2 0.69314718055994531
+
+static bool ready = false;
+
+static double exp_int[AA_EXP_MAX - AA_EXP_MIN];  // exp(n)
+static double exp_frac[AA_TABLE_STEPS];          // exp(j/256)
+static double log_tab[AA_TABLE_STEPS];           // log(1+j/256)
+static double sin_tab[AA_TRIGO_STEPS];           // sin(j/256)
+static double cos_tab[AA_TRIGO_STEPS];           // cos(j/256)
+
+
+void aa_table_init() {
+    if (ready)
+        return;
+
+    for (int n = AA_EXP_MIN; n < AA_EXP_MAX; n++)
+        exp_int[n - AA_EXP_MIN] = exp((double)n);
+
+    for (unsigned j = 0; j < AA_TABLE_STEPS; j++) {
+        const double x = (double)j/AA_TABLE_STEPS;
+        exp_frac[j] = exp(x);
+        log_tab[j] = log1p(x);
+    }
+
+    for (unsigned j = 0; j < AA_TRIGO_STEPS; j++) {
+        const double x = (double)j/AA_TABLE_STEPS;
+        sin_tab[j] = sin(x);
+        cos_tab[j] = cos(x);
+    }
+
+    ready = true;
+}
+
+
+// Widen v by err and by the ulps of the computation
+
+static interval widen(double v, double err) {
+    err += AA_TABLE_ERR*fabs(v) + DBL_MIN;
+    return interval(v - err, v + err);
+}
+
+
+// exp(x) = exp(n) * exp(j/256) * exp(r)
+
+bool aa_exp_bound(double x, interval & e) {
+    if (!ready || !(x >= AA_EXP_MIN) || !(x < AA_EXP_MAX - 1))
+        return false;
+
+    const double n = floor(x);
+    const double f = x - n;
+    const unsigned j = (unsigned)(f*AA_TABLE_STEPS);
+    const double r = f - (double)j/AA_TABLE_STEPS;
+
+    // Taylor up to r^6, the remainder is below 2^-68
+
+    const double er = 1 + r*(1 + r*(1./2 + r*(1./6 + r*(1./24 + r*(1./120
+                                                                  + r/720)))));
+
+    e = widen(exp_int[(int)n - AA_EXP_MIN]*exp_frac[j]*er, 0);
+    return true;
+}
+
+
+// log(x) = k*log(2) + log(1+j/256) + log(1+r)
+
+bool aa_log_bound(double x, interval & l) {
+    if (!ready || !(x >= DBL_MIN) || !(x <= DBL_MAX))
+        return false;
+
+    int k;
+    const double f = 2*frexp(x, &k); // f in [1,2)
+    k--;
+
+    const unsigned j = (unsigned)((f - 1)*AA_TABLE_STEPS);
+    const double c = 1 + (double)j/AA_TABLE_STEPS;
+    const double r = (f - c)/c;
+
+    // Taylor up to r^8, the remainder is below 2^-75
+
+    const double lr = r*(1 - r*(1./2 - r*(1./3 - r*(1./4 - r*(1./5 - r*(1./6
+                                                                  - r*(1./7 - r/8)))))));
+    const double kl = k*LN2;
+
+    l = widen(kl + log_tab[j] + lr, AA_TABLE_ERR*(fabs(kl) + log_tab[j]));
+    return true;
+}
+
+
+// sin(x) and cos(x) after reduction of x to [0,2*PI)
+// sin(y + r) = sin(y)*cos(r) + cos(y)*sin(r)
+// cos(y + r) = cos(y)*cos(r) - sin(y)*sin(r)
+
+bool aa_sincos_bound(double x, interval & s, interval & c) {
+    if (!ready || !(fabs(x) <= AA_TRIGO_MAX))
+        return false;
+
+    const double k = floor(x/TWO_PI_1);
+    const double y = ((x - k*TWO_PI_1) - k*TWO_PI_2) - k*TWO_PI_3;
+
+    int j = (int)floor(y*AA_TABLE_STEPS);
+    if (j < 0)
+        j = 0;
+    if (j >= AA_TRIGO_STEPS)
+        j = AA_TRIGO_STEPS - 1;
+    const double r = y - (double)j/AA_TABLE_STEPS;
+
+    // Taylor up to r^7 and r^8, the remainders are below 2^-80
+
+    const double r2 = r*r;
+    const double sr = r*(1 - r2*(1./6 - r2*(1./120 - r2/5040)));
+    const double cr = 1 - r2*(1./2 - r2*(1./24 - r2*(1./720 - r2/40320)));
+
+    // error of the reduction, bounded by a few ulps of y
+
+    const double red = AA_TABLE_ERR*(fabs(y) + TWO_PI_1);
+
+    const double ss = sin_tab[j]*cr;
+    const double sc = cos_tab[j]*sr;
+    const double cc = cos_tab[j]*cr;
+    const double cs = sin_tab[j]*sr;
+
+    s = widen(ss + sc, red + AA_TABLE_ERR*(fabs(ss) + fabs(sc)));
+    c = widen(cc - cs, red + AA_TABLE_ERR*(fabs(cc) + fabs(cs)));
+    return true;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,57 @@
+/*
+ * aa_table.h -- Table driven elementary functions
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef AA_TABLE_H
+#define AA_TABLE_H
+
+#include "aa_interval.h"
+
+// The fast mode of the non-affine operations (see AAF::set_fast_mode)
+// is used for intervals narrower than this
+
+#define AA_NARROW_WIDTH (1.0/256)
+
+// Build the tables
+// Done once, the first time the fast mode is turned on
+
+void aa_table_init();
+
+// Enclosures of exp(x), log(x), sin(x) and cos(x)
+// The bounds are widened by a few ulps so that they hold
+// whatever the rounding mode was during the computation
+// These return false if x is out of the range of the tables
+
+bool aa_exp_bound(double x, interval & e);
+bool aa_log_bound(double x, interval & l);
+bool aa_sincos_bound(double x, interval & s, interval & c);
+
+#endif
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
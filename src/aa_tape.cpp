@@ -0,0 +1,249 @@
+/*
+ * aa_tape.cpp -- Reverse mode derivatives of AAFs
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include "aa_tape.h"
+#include "aa_deriv.h"
+
+
+// Record a new input x
+
+aaf_var aa_tape::input(const AAF & x) {
+    record r;
+    r.value = x;
+    r.nargs = 0;
+
+    inputs.push_back(records.size());
+    return push(r);
+}
+
+
+// Forget everything (the aaf_vars on the tape can't be used anymore)
+
+void aa_tape::clear() {
+    records.clear();
+    inputs.clear();
+}
+
+
+unsigned aa_tape::get_inputs() const {
+    return inputs.size();
+}
+
+
+// Number of operations recorded, the inputs included
+
+unsigned aa_tape::size() const {
+    return records.size();
+}
+
+
+aaf_var aa_tape::push(const record & r) {
+    records.push_back(r);
+    return aaf_var(this, records.size() - 1);
+}
+
+
+// The constant operands are not recorded, f(u) of a constant u is a
+// constant
+
+aaf_var aa_tape::unary(const aaf_var & u, const AAF & fu, const AAF & fp) {
+    if (u.is_constant())
+        return aaf_var(fu);
+
+    record r;
+    r.value = fu;
+    r.nargs = 1;
+    r.arg[0] = u.node;
+    r.partial[0] = fp;
+    return u.tape->push(r);
+}
+
+aaf_var aa_tape::binary(const aaf_var & a, const aaf_var & b, const AAF & fab,
+                        const AAF & da, const AAF & db)
+{
+    if (a.is_constant())
+        return unary(b, fab, db);
+    if (b.is_constant())
+        return unary(a, fab, da);
+
+    record r;
+    r.value = fab;
+    r.nargs = 2;
+    r.arg[0] = a.node;
+    r.arg[1] = b.node;
+    r.partial[0] = da;
+    r.partial[1] = db;
+    return a.tape->push(r);
+}
+
+
+// Partial derivatives of f by the inputs in grad, in the order the
+// inputs were recorded
+// The adjoint of each operation (df/d(its value)) is propagated to
+// its operands, from the last one to the first one : an operation
+// is reached once all the operations using it are done
+
+void aa_tape::gradient(const aaf_var & f, AAF * grad) const {
+    for (unsigned i = 0; i < inputs.size(); i++)
+        grad[i] = 0.;
+    if (f.is_constant())
+        return;
+
+    std::vector<AAF> adj(f.node + 1);
+    std::vector<bool> reached(f.node + 1, false);
+    adj[f.node] = 1.;
+    reached[f.node] = true;
+
+    for (unsigned k = f.node + 1; k-- > 0; ) {
+        const record & r = records[k];
+        if (!reached[k] || !r.nargs)
+            continue;
+
+        for (unsigned j = 0; j < r.nargs; j++) {
+            const unsigned a = r.arg[j];
+            const AAF d = aa_times(adj[k], r.partial[j]);
+            adj[a] = reached[a] ? adj[a] + d : d;
+            reached[a] = true;
+        }
+        adj[k] = 0.;  // (not needed anymore)
+    }
+
+    for (unsigned i = 0; i < inputs.size(); i++)
+        if (inputs[i] <= f.node)
+            grad[i] = adj[inputs[i]];
+}
+
+
+// Arithmetic
+
+aaf_var operator + (const aaf_var & a, const aaf_var & b) {
+    return aa_tape::binary(a, b, a.value() + b.value(), 1., 1.);
+}
+
+aaf_var operator - (const aaf_var & a, const aaf_var & b) {
+    return aa_tape::binary(a, b, a.value() - b.value(), 1., -1.);
+}
+
+aaf_var operator - (const aaf_var & a) {
+    return aa_tape::unary(a, -a.value(), -1.);
+}
+
+aaf_var operator * (const aaf_var & a, const aaf_var & b) {
+    return aa_tape::binary(a, b, aa_times(a.value(), b.value()), b.value(), a.value());
+}
+
+// d(a/b)/db = -(a/b)/b, with 1/b computed once
+
+aaf_var operator / (const aaf_var & a, const aaf_var & b) {
+    const AAF ib = inv(b.value());
+    const AAF q = aa_times(a.value(), ib);
+    return aa_tape::binary(a, b, q, ib, -aa_times(q, ib));
+}
+
+
+// Elementary functions (see aa_deriv.h)
+
+static aaf_var chain(const aaf_var & u, const aa_deriv & f) {
+    return aa_tape::unary(u, f.value, f.slope);
+}
+
+aaf_var sqr(const aaf_var & u) {
+    return chain(u, aa_deriv_sqr(u.value()));
+}
+
+aaf_var sqrt(const aaf_var & u) {
+    return chain(u, aa_deriv_sqrt(u.value()));
+}
+
+aaf_var inv(const aaf_var & u) {
+    return chain(u, aa_deriv_inv(u.value()));
+}
+
+aaf_var exp(const aaf_var & u) {
+    return chain(u, aa_deriv_exp(u.value()));
+}
+
+aaf_var log(const aaf_var & u) {
+    return chain(u, aa_deriv_log(u.value()));
+}
+
+aaf_var pow(const aaf_var & u, int n) {
+    if (n == 0)
+        return aaf_var(1.);
+    return chain(u, aa_deriv_pow(u.value(), n));
+}
+
+aaf_var pow(const aaf_var & u, double p) {
+    if (p == 0)
+        return aaf_var(1.);
+    if (p == 1)
+        return u;
+    return chain(u, aa_deriv_pow(u.value(), p));
+}
+
+aaf_var abs(const aaf_var & u) {
+    return chain(u, aa_deriv_abs(u.value()));
+}
+
+aaf_var sin(const aaf_var & u) {
+    return chain(u, aa_deriv_sin(u.value()));
+}
+
+aaf_var cos(const aaf_var & u) {
+    return chain(u, aa_deriv_cos(u.value()));
+}
+
+aaf_var tan(const aaf_var & u) {
+    return chain(u, aa_deriv_tan(u.value()));
+}
+
+aaf_var sinh(const aaf_var & u) {
+    return chain(u, aa_deriv_sinh(u.value()));
+}
+
+aaf_var cosh(const aaf_var & u) {
+    return chain(u, aa_deriv_cosh(u.value()));
+}
+
+aaf_var tanh(const aaf_var & u) {
+    return chain(u, aa_deriv_tanh(u.value()));
+}
+
+aaf_var asinh(const aaf_var & u) {
+    return chain(u, aa_deriv_asinh(u.value()));
+}
+
+aaf_var acosh(const aaf_var & u) {
+    return chain(u, aa_deriv_acosh(u.value()));
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
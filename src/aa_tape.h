@@ -0,0 +1,166 @@
+/*
+ * aa_tape.h -- Reverse mode derivatives of AAFs
+ *
+ * This file is part of libaffa.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libaffa; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef AA_TAPE_H
+#define AA_TAPE_H
+
+#include "aa_aaf.h"
+#include <deque>
+#include <vector>
+
+class aa_tape;
+
+
+// An AAF recorded on a tape (or a constant, on no tape : the
+// constants are folded into the operations recorded)
+// The operations on them are done in AA and recorded with their
+// partial derivatives, so a function template written for AAF can be
+// evaluated on aaf_var as is
+
+class aaf_var
+{
+
+private:
+    aa_tape * tape;    // NULL for a constant
+    unsigned node;
+    AAF cst;
+
+    aaf_var(aa_tape * tape, unsigned node) : tape(tape), node(node) {}
+
+    friend class aa_tape;
+
+public:
+
+    aaf_var(double c = 0) : tape(NULL), node(0), cst(c) {}
+    aaf_var(const AAF & c) : tape(NULL), node(0), cst(c) {}
+
+    const AAF & value() const;
+    bool is_constant() const {
+        return tape == NULL;
+    }
+};
+
+
+// The operations done on the aaf_vars of a function f(x[0] ... x[n-1]),
+// in the order they were done
+//
+// Each one keeps its result and the derivatives of the result by its
+// operands, enclosed in AA on the ranges of the operands (e.g. cos(u)
+// for sin(u)), so gradient() finds the enclosures of all the partial
+// derivatives df/dx[i] in one backward sweep, whatever n is
+//
+//   aa_tape tape;
+//   aaf_var x = tape.input(AAF(interval(1, 2)));
+//   aaf_var y = tape.input(AAF(interval(0, 1)));
+//   aaf_var f = x*exp(y) + 1.;
+//   AAF df[2];
+//   tape.gradient(f, df);
+//
+// The derivatives share the noise symbols of the inputs and of the
+// intermediate results with f
+
+class aa_tape
+{
+
+private:
+    struct record
+    {
+        AAF value;
+        unsigned nargs;    // 0 for the inputs
+        unsigned arg[2];
+        AAF partial[2];    // d(value)/d(arg)
+    };
+
+    std::deque<record> records;  // (the values don't move when it grows)
+    std::vector<unsigned> inputs;
+
+    aaf_var push(const record & r);
+
+    aa_tape(const aa_tape &);
+    aa_tape & operator = (const aa_tape &);
+
+    friend class aaf_var;
+
+public:
+
+    aa_tape() {}
+
+    aaf_var input(const AAF & x);
+    void clear();
+
+    unsigned get_inputs() const;
+    unsigned size() const;
+
+    void gradient(const aaf_var & f, AAF * grad) const;
+
+    // Record f(u) of value fu and derivative fp, and f(a,b) of value
+    // fab and partial derivatives da and db (the functions of the
+    // library are recorded with them, others can be too)
+
+    static aaf_var unary(const aaf_var & u, const AAF & fu, const AAF & fp);
+    static aaf_var binary(const aaf_var & a, const aaf_var & b, const AAF & fab,
+                          const AAF & da, const AAF & db);
+};
+
+
+aaf_var operator + (const aaf_var & a, const aaf_var & b);
+aaf_var operator - (const aaf_var & a, const aaf_var & b);
+aaf_var operator - (const aaf_var & a);
+aaf_var operator * (const aaf_var & a, const aaf_var & b);
+aaf_var operator / (const aaf_var & a, const aaf_var & b);
+
+aaf_var sqr(const aaf_var & u);
+aaf_var sqrt(const aaf_var & u);
+aaf_var inv(const aaf_var & u);
+aaf_var exp(const aaf_var & u);
+aaf_var log(const aaf_var & u);
+aaf_var pow(const aaf_var & u, int n);
+aaf_var pow(const aaf_var & u, double p);
+aaf_var abs(const aaf_var & u);
+aaf_var sin(const aaf_var & u);
+aaf_var cos(const aaf_var & u);
+aaf_var tan(const aaf_var & u);
+aaf_var sinh(const aaf_var & u);
+aaf_var cosh(const aaf_var & u);
+aaf_var tanh(const aaf_var & u);
+aaf_var asinh(const aaf_var & u);
+aaf_var acosh(const aaf_var & u);
+
+
+// The value of v (the tape must still hold it)
+
+inline const AAF & aaf_var::value() const {
+    return tape ? tape->records[node].value : cst;
+}
+
+#endif  // AA_TAPE_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+
+
+// vim: filetype=c++:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -23,25 +23,306 @@
 #define AA_UTIL
 
 #include "aa_aaf.h"
+#include "aa_rounding.h"
+#include "aa_stats.h"
+#include "aa_provenance.h"
+#include <algorithm>
+#include <cstring>
+
+// (AAF_TYPE_NAN without AAF_TYPE_AFFINE is a form with no value left,
+// whether or not AAF_TYPE_INFINITE came along)
+
 #define handle_infinity(x) {\
-    if ((x).get_special() == AAF_TYPE_NAN) \
+    if (((x).get_special() & (AAF_TYPE_NAN | AAF_TYPE_AFFINE)) == AAF_TYPE_NAN) \
         return AAF(AAF_TYPE_NAN); \
     if ((x).get_special() == AAF_TYPE_INFINITE) \
         return AAF(interval(-HUGE_VAL, HUGE_VAL)); \
 }
 
+// The type of a binary operation on forms of types a and b, which is
+// infinite as soon as one of them is
+
 inline static AAF_TYPE binary_special(AAF_TYPE a, AAF_TYPE b) {
-    if((a == AAF_TYPE_AFFINE) &&
-       (b == AAF_TYPE_AFFINE)) {
-        return AAF_TYPE_AFFINE;
-    } else if((a == AAF_TYPE_NAN) ||
-            (b == AAF_TYPE_NAN)) {
-        return AAF_TYPE_NAN;
-    } else if((a == (AAF_TYPE)(AAF_TYPE_NAN | AAF_TYPE_AFFINE)) ||
-            (b == (AAF_TYPE)(AAF_TYPE_NAN | AAF_TYPE_AFFINE))) {
-        return (AAF_TYPE)(AAF_TYPE_NAN | AAF_TYPE_AFFINE);
-    }
-    return (AAF_TYPE)(a | b);
+    const AAF_TYPE inf = (AAF_TYPE)((a | b) & AAF_TYPE_INFINITE);
+    a = (AAF_TYPE)(a & ~AAF_TYPE_INFINITE);
+    b = (AAF_TYPE)(b & ~AAF_TYPE_INFINITE);
+    if((a == AAF_TYPE_NAN) ||
+       (b == AAF_TYPE_NAN)) {
+        return (AAF_TYPE)(AAF_TYPE_NAN | inf);
+    }
+    return (AAF_TYPE)(a | b | inf);
+}
+
+
+// Instrumentation (see aa_stats.h and aa_provenance.h)
+// AA_STAT_OP() is called when an operation starts, the errors and the
+// new noise symbols are charged to the outermost operation running
+// (cos is sin(P + PI/2) and cosh adds two exp, their symbols are the
+// ones of cos and cosh) until it returns
+
+extern __thread int aa_current_op;
+extern bool aa_provenance_on;
+
+#ifdef AA_STATS
+extern __thread aa_stats aa_stats_local;
+
+inline void aa_stat_form(unsigned length) {
+    unsigned k = 0;
+    while ((length >> k) && (k < AA_STATS_BUCKETS - 1))
+        k++;
+    aa_stats_local.forms++;
+    aa_stats_local.total_length += length;
+    aa_stats_local.lengths[k]++;
+}
+
+inline void aa_stat_error(double e) {
+    if ((aa_current_op >= 0) && (fabs(e) > aa_stats_local.max_error[aa_current_op]))
+        aa_stats_local.max_error[aa_current_op] = fabs(e);
+}
+
+#define AA_STAT_FORM(length) aa_stat_form(length)
+#define AA_STAT_ERROR(e) aa_stat_error(e)
+#define AA_STAT_SYMBOL() (aa_stats_local.symbols++)
+#define AA_STAT_ALLOC(n) (aa_stats_local.allocations += (n))
+#else
+#define AA_STAT_FORM(length) ((void)0)
+#define AA_STAT_ERROR(e) ((void)0)
+#define AA_STAT_SYMBOL() ((void)0)
+#define AA_STAT_ALLOC(n) ((void)0)
+#endif
+
+// aa_current_op is op from the construction to the destruction, unless
+// an operation is already running
+// Without AA_STATS it's only read to tag the new symbols, so it's left
+// alone when the provenance mode is off
+
+class aa_op_scope
+{
+private:
+    bool outer;
+
+public:
+    aa_op_scope(int op) {
+#ifdef AA_STATS
+        aa_stats_local.calls[op]++;
+        outer = (aa_current_op < 0);
+#else
+        outer = aa_provenance_on && (aa_current_op < 0);
+#endif
+        if (outer)
+            aa_current_op = op;
+    }
+    ~aa_op_scope() {
+        if (outer)
+            aa_current_op = -1;
+    }
+};
+
+#define AA_STAT_OP(op) aa_op_scope aa_op_scope_(op)
+
+#define AA_TAG_SYMBOL(index, what) \
+    (aa_provenance_on ? aa_provenance_tag((index), (what)) : (void)0)
+
+
+// Round-off of the affine kernels
+// Inside an aa_rounding_scope the operations are rounded up and their
+// errors bounded with aa_add_up() and aa_mul_up()
+// When the library is built with AA_RIGOROUS they are done in round
+// to nearest and their exact errors come from aa_two_sum() and
+// aa_two_prod() (i.e. ./configure CPPFLAGS=-DAA_RIGOROUS)
+// Otherwise the round-off is ignored
+
+class aa_roundoff
+{
+private:
+    bool up;      // in an aa_rounding_scope
+    bool eft;     // error free transformations
+    double err;   // sum of the errors
+    unsigned n;   // number of errors in err
+
+public:
+    aa_roundoff()
+        : up(aa_rounding_scope::active()), err(0), n(0)
+    {
+#ifdef AA_RIGOROUS
+        eft = !up;
+#else
+        eft = false;
+#endif
+    }
+
+    bool active() const {
+        return up || eft;
+    }
+
+    double add(double a, double b) {
+        if (up)
+            return aa_add_up(a, b, err);
+        if (!eft)
+            return a + b;
+        double e;
+        const double s = aa_two_sum(a, b, e);
+        if (fabs(s) < HUGE_VAL && e != 0) {  // (e is exact, even on underflow)
+            err += fabs(e);
+            n++;
+        }
+        return s;
+    }
+
+    double mul(double a, double b) {
+        if (up)
+            return aa_mul_up(a, b, err);
+        if (!eft)
+            return a*b;
+        double e;
+        const double p = aa_two_prod(a, b, e);
+        if (fabs(p) < HUGE_VAL) {
+            err += fabs(e);
+            n++;
+        }
+        return p;
+    }
+
+    // Bound of |delta| + the errors so far, 0 when nothing was rounded
+    // delta comes from k operations of round to nearest on non
+    // negative terms, so it is within k ulps
+    // (when not active, delta is returned as is)
+
+    double error(double delta = 0, unsigned k = 1) const;
+};
+
+inline double aa_roundoff::error(double delta, unsigned k) const {
+    if (up)
+        return ((delta != 0) ? aa_round_up(fabs(delta)) : 0) + err;
+    if (!eft)
+        return delta;
+    if (delta == 0 && n == 0)
+        return 0;
+
+    // each error of err is exact, but underflow may add
+    // a denormal to it, and the sum itself is rounded n times
+
+    const double e = (err + n*AA_MIN_DENORM)*(1 + n*DBL_EPSILON);
+    return aa_round_up(fabs(delta)*(1 + k*DBL_EPSILON) + e);
+}
+
+// Merge of the sorted lists of terms (id1,va1) and (id2,va2) into
+// (idr,var), returns the length of the result
+// A symbol found in the first list only gets op.first(x), in the
+// second only op.second(y) and in both op.both(x,y) ; when
+// Op::copy_first (Op::copy_second) is set, op.first() (op.second())
+// returns x as is and the runs of that list are copied with memcpy
+// When all the symbols of a list are before the ones of the other
+// (e.g. independent inputs) the lists are just concatenated, and when
+// a list is much shorter than the other (e.g. an input with a single
+// symbol and a long intermediate result) the place of each of its
+// symbols in the long one is found with an exponential search
+
+#define AA_GALLOP_RATIO 8
+
+// First position in [lo,n) where id[pos] >= x
+
+inline unsigned aa_gallop(const aa_symbol * id, unsigned lo, unsigned n, aa_symbol x) {
+    unsigned hi = lo;
+    unsigned step = 1;
+
+    while (hi < n && id[hi] < x) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+
+    if (hi > n)
+        hi = n;
+    return std::lower_bound(id + lo, id + hi, x) - id;
+}
+
+template <class Op>
+inline unsigned aa_merge_copy(const aa_symbol * id, const double * va, unsigned n, bool first,
+                              aa_symbol * idr, double * var, Op & op)
+{
+    memcpy(idr, id, n*sizeof(aa_symbol));
+
+    if (first ? Op::copy_first : Op::copy_second)
+        memcpy(var, va, n*sizeof(double));
+    else if (first)
+        for (unsigned i = 0; i < n; i++)
+            var[i] = op.first(va[i]);
+    else
+        for (unsigned i = 0; i < n; i++)
+            var[i] = op.second(va[i]);
+
+    return n;
+}
+
+template <class Op>
+unsigned aa_merge(const aa_symbol * id1, const double * va1, unsigned l1,
+                  const aa_symbol * id2, const double * va2, unsigned l2,
+                  aa_symbol * idr, double * var, Op & op)
+{
+    unsigned k;
+
+    // disjoint ranges
+
+    if (!l2 || (l1 && id1[l1-1] < id2[0])) {
+        k = aa_merge_copy(id1, va1, l1, true, idr, var, op);
+        return k + aa_merge_copy(id2, va2, l2, false, idr+k, var+k, op);
+    }
+
+    if (!l1 || id2[l2-1] < id1[0]) {
+        k = aa_merge_copy(id2, va2, l2, false, idr, var, op);
+        return k + aa_merge_copy(id1, va1, l1, true, idr+k, var+k, op);
+    }
+
+    unsigned a = 0, b = 0;
+    k = 0;
+
+    if (l2 >= AA_GALLOP_RATIO*l1) {
+        // gallop in the second list
+        while (a < l1) {
+            const unsigned e = aa_gallop(id2, b, l2, id1[a]);
+            k += aa_merge_copy(id2+b, va2+b, e-b, false, idr+k, var+k, op);
+            b = e;
+
+            idr[k] = id1[a];
+            if (b < l2 && id2[b] == id1[a])
+                var[k++] = op.both(va1[a++], va2[b++]);
+            else
+                var[k++] = op.first(va1[a++]);
+        }
+    } else if (l1 >= AA_GALLOP_RATIO*l2) {
+        // gallop in the first list
+        while (b < l2) {
+            const unsigned e = aa_gallop(id1, a, l1, id2[b]);
+            k += aa_merge_copy(id1+a, va1+a, e-a, true, idr+k, var+k, op);
+            a = e;
+
+            idr[k] = id2[b];
+            if (a < l1 && id1[a] == id2[b])
+                var[k++] = op.both(va1[a++], va2[b++]);
+            else
+                var[k++] = op.second(va2[b++]);
+        }
+    } else {
+        while (a < l1 && b < l2) {
+            if (id1[a] < id2[b]) {
+                idr[k] = id1[a];
+                var[k++] = op.first(va1[a++]);
+            } else if (id2[b] < id1[a]) {
+                idr[k] = id2[b];
+                var[k++] = op.second(va2[b++]);
+            } else {
+                idr[k] = id1[a];
+                var[k++] = op.both(va1[a++], va2[b++]);
+            }
+        }
+    }
+
+    // what is left of either list
+
+    k += aa_merge_copy(id1+a, va1+a, l1-a, true, idr+k, var+k, op);
+    k += aa_merge_copy(id2+b, va2+b, l2-b, false, idr+k, var+k, op);
+    return k;
 }
 
 #endif